@@ -5,10 +5,22 @@
 // Based on AGENTS.md specification §4, §5
 // Features:
 //   - Layer-wise processing
-//   - 2/4/8/16 bit activation and weight support
-//   - Stride 1 or 2
-//   - Inter-cycle accumulation for input channel groups
+//   - 2/4/8/16 bit activation and weight support, any combination
+//   - Stride 1 or 2, valid or same (pad=1) convolution
+//   - Inter-cycle accumulation for input channel groups, output-stationary:
+//     each window is held while all OC groups' weights stream past it
 //   - Constraint checking with error codes
+//   - Queued next-layer config; with WGT_PINGPONG the next layer's weights
+//     load while the current layer convolves
+//   - Vector output path: each accumulator result goes to the stub and
+//     packer in one handshake
+//   - Column tiles: a layer wider than MAX_W runs as vertical stripes, one
+//     tile descriptor (cfg_tile_x0, cfg_tile_W) per run
+//   - Batch mode: cfg_batch images stream through against one weight load,
+//     with out_last per image and done after the last one
+//   - Optional fused post-ops (bias / folded BN, ReLU, per-channel
+//     requantization to 2/4/8/16-bit codes), densely packed in the
+//     activation stream format
 //============================================================================
 
 module conv3x3_accel_top #(
@@ -21,7 +33,9 @@ module conv3x3_accel_top #(
     parameter int MAX_OC       = 256,       // Max output channels
     parameter int ACC_W        = 32,        // Accumulator width
     parameter int KH           = 3,         // Kernel height (fixed)
-    parameter int KW           = 3          // Kernel width (fixed)
+    parameter int KW           = 3,         // Kernel width (fixed)
+    parameter int WGT_PINGPONG = 1,         // Double-buffered weight_buffer
+    parameter int PIPE_STAGES  = 1          // conv_core register stages (1..4)
 )(
     //========================================================================
     // Clock and Reset
@@ -37,14 +51,50 @@ module conv3x3_accel_top #(
     input  logic [15:0] cfg_W, cfg_H,       // Input dimensions
     input  logic [15:0] cfg_IC, cfg_OC,     // Channel dimensions
     input  logic        cfg_stride,         // 0=stride1, 1=stride2
+    input  logic        cfg_pad,            // 0=valid, 1=same (one-pixel border)
+    input  logic        cfg_pad_use_code,   // Border taps: 0=zero, 1=cfg_pad_code
+    input  logic [15:0] cfg_pad_code,       // Activation code of border taps
+    input  logic [15:0] cfg_tile_x0,        // First input column of the tile
+    input  logic [15:0] cfg_tile_W,         // Tile input columns, 0 = no tiling
     input  logic [4:0]  cfg_act_bits,       // 2, 4, 8, 16
     input  logic [4:0]  cfg_wgt_bits,       // 2, 4, 8, 16
-    input  logic        cfg_mode_raw_out,   // 1=raw ACC_W output (MVP)
+    input  logic        cfg_mode_raw_out,   // 1=raw ACC_W output, 0=requantized
+    input  logic [4:0]  cfg_out_bits,       // 2, 4, 8, 16 (when !cfg_mode_raw_out)
+    input  logic        cfg_relu,           // ReLU before requantization
+    input  logic [7:0]  cfg_batch,          // Images per weight load (0 = 1)
 
     input  logic        start,              // Start pulse
-    output logic        done,               // Layer done
+    output logic        done,               // Layer (whole batch) done
     output logic [3:0]  error_code,         // Error code (0=none)
 
+    //========================================================================
+    // Performance Counters (read-only; cleared when a layer starts,
+    // held after done until the next start)
+    //========================================================================
+    output logic [31:0] perf_cyc_total,     // Cycles from start to done
+    output logic [31:0] perf_cyc_load_wgt,  // Cycles in ST_LOAD_WGT
+    output logic [31:0] perf_cyc_conv,      // Cycles in ST_LOAD_ACT_AND_CONV
+    output logic [31:0] perf_cyc_drain,     // Cycles in ST_DRAIN_OUT
+    output logic [31:0] perf_core_fire,     // core_in_valid && core_in_ready
+    output logic [31:0] perf_stall_win,     // Conv cycles without a window
+    output logic [31:0] perf_stall_wgt,     // Window ready, weights not valid
+    output logic [31:0] perf_stall_stub,    // Result vector blocked by stub_in_ready
+    output logic [31:0] perf_stall_out,     // out_valid held by out_ready low
+    output logic [31:0] perf_core_burst,    // Longest run of back-to-back core fires
+
+    //========================================================================
+    // Output Post-Op Parameters
+    // Per-OC bias/scale/shift for the next layer started with !cfg_mode_raw_out:
+    // write them, then send that layer's config. prm_wr_ready drops while
+    // the bank they would land in still belongs to the running layer.
+    //========================================================================
+    input  logic        prm_wr_valid,
+    output logic        prm_wr_ready,
+    input  logic [15:0] prm_wr_oc,          // Output channel
+    input  logic signed [31:0] prm_wr_bias, // Added to the accumulator (BN fold)
+    input  logic signed [15:0] prm_wr_scale,// Multiplier
+    input  logic [4:0]  prm_wr_shift,       // Rounding right shift
+
     //========================================================================
     // Weight Input Stream (§4.4)
     //========================================================================
@@ -67,7 +117,7 @@ module conv3x3_accel_top #(
     output logic        out_valid,
     input  logic        out_ready,
     output logic [BUS_W-1:0] out_data,
-    output logic        out_last
+    output logic        out_last            // Last beat of each image
 );
 
     //========================================================================
@@ -88,14 +138,39 @@ module conv3x3_accel_top #(
     // Calculate output dimensions
     function automatic logic [15:0] calc_out_dim(
         input logic [15:0] in_dim, 
-        input logic stride
+        input logic stride,
+        input logic pad
     );
-        if (in_dim < 16'd3)
+        logic [16:0] eff_dim;
+        eff_dim = {1'b0, in_dim} + (pad ? 17'd2 : 17'd0);
+        if (eff_dim < 17'd3)
             return 16'd0;
         else if (stride)
-            return ((in_dim - 16'd3) >> 1) + 16'd1;
+            return 16'(((eff_dim - 17'd3) >> 1) + 17'd1);
         else
-            return (in_dim - 16'd3) + 16'd1;
+            return 16'((eff_dim - 17'd3) + 17'd1);
+    endfunction
+    
+    // First output column and output columns of a column tile (same
+    // arithmetic as feature_line_buffer)
+    function automatic logic [15:0] calc_tile_ox0(input logic [15:0] x0, input logic stride,
+                                                  input logic pad);
+        logic [16:0] xs;
+        xs = (x0 == 16'd0) ? 17'd0 : {1'b0, x0} + {16'd0, pad};
+        return 16'(stride ? ((xs + 17'd1) >> 1) : xs);
+    endfunction
+    
+    function automatic logic [15:0] calc_tile_ow(input logic [15:0] W, input logic [15:0] x0,
+                                                 input logic [15:0] cols, input logic stride,
+                                                 input logic pad);
+        logic [17:0] xe, lo, hi;
+        xe = ({2'b0, x0} + {2'b0, cols} >= {2'b0, W}) ? {2'b0, W} + (pad ? 18'd2 : 18'd0) :
+                                                        {2'b0, x0} + {2'b0, cols} + {17'd0, pad};
+        if (xe < 18'd3)
+            return 16'd0;
+        lo = {2'b0, calc_tile_ox0(x0, stride, pad)};
+        hi = stride ? ((xe - 18'd3) >> 1) : (xe - 18'd3);
+        return (hi >= lo) ? 16'(hi - lo + 18'd1) : 16'd0;
     endfunction
 
     //========================================================================
@@ -103,18 +178,91 @@ module conv3x3_accel_top #(
     //========================================================================
     logic [15:0] r_W, r_H, r_IC, r_OC;
     logic        r_stride;
+    logic        r_pad, r_pad_use_code;
+    logic [15:0] r_pad_code;
+    logic [15:0] r_tile_x0, r_tile_W;
+    logic [15:0] r_tile_ox0;            // Layer column of the tile's first output
     logic [4:0]  r_act_bits, r_wgt_bits;
     logic [3:0]  r_act_slices, r_wgt_slices;
     logic [4:0]  r_IC_CH_PER_CYCLE;     // Channels per cycle for input
     logic [4:0]  r_OC_CH_PER_CYCLE;     // Channels per cycle for output
     logic [7:0]  r_num_ic_grp;          // Number of input channel groups
     logic [7:0]  r_num_oc_grp;          // Number of output channel groups
-    logic [15:0] r_OH, r_OW;            // Output dimensions
+    logic [15:0] r_OH, r_OW;            // Output dimensions (r_OW of the tile)
+    logic [5:0]  r_out_bits;            // Output element bits, 32 = raw
+    logic        r_relu;
+    logic [7:0]  r_batch;               // Images in this layer, >= 1
+    logic        r_prm_bank;            // Post-op parameter bank in use
     
     // Config valid flag
     logic config_valid;
     logic config_error;
     logic [3:0] config_error_code;
+    
+    // Queued next-layer configuration: accepted (with start) while a layer
+    // is running and launched from ST_DONE without going back to IDLE
+    logic [15:0] q_W, q_H, q_IC, q_OC;
+    logic        q_stride;
+    logic        q_pad, q_pad_use_code;
+    logic [15:0] q_pad_code;
+    logic [15:0] q_tile_x0, q_tile_W;
+    logic [4:0]  q_act_bits, q_wgt_bits;
+    logic        q_raw_out;
+    logic [4:0]  q_out_bits;
+    logic        q_relu;
+    logic [7:0]  q_batch;
+    logic        q_prm_bank;
+    logic        q_valid;
+    logic        cfg_load;              // r_* loaded (IDLE config or promote)
+    logic        cfg_queue;             // cfg accepted into the queue slot
+    logic        promote;               // Queued layer becomes current
+    logic        err_promoted;          // ST_CFG_ERROR entered from a queued layer
+    
+    // Config source for checking/loading: the queue slot when promoting
+    logic [15:0] src_W, src_H, src_IC, src_OC;
+    logic        src_stride;
+    logic        src_pad, src_pad_use_code;
+    logic [15:0] src_pad_code;
+    logic [15:0] src_tile_x0, src_tile_W;
+    logic [4:0]  src_act_bits, src_wgt_bits;
+    logic        src_raw_out;
+    logic [4:0]  src_out_bits;
+    logic        src_relu;
+    logic [7:0]  src_batch;
+    
+    always_comb begin
+        src_W        = promote ? q_W        : cfg_W;
+        src_H        = promote ? q_H        : cfg_H;
+        src_IC       = promote ? q_IC       : cfg_IC;
+        src_OC       = promote ? q_OC       : cfg_OC;
+        src_stride   = promote ? q_stride   : cfg_stride;
+        src_pad      = promote ? q_pad      : cfg_pad;
+        src_pad_use_code = promote ? q_pad_use_code : cfg_pad_use_code;
+        src_pad_code = promote ? q_pad_code : cfg_pad_code;
+        src_tile_x0  = promote ? q_tile_x0  : cfg_tile_x0;
+        src_tile_W   = promote ? q_tile_W   : cfg_tile_W;
+        src_act_bits = promote ? q_act_bits : cfg_act_bits;
+        src_wgt_bits = promote ? q_wgt_bits : cfg_wgt_bits;
+        src_raw_out  = promote ? q_raw_out  : cfg_mode_raw_out;
+        src_out_bits = promote ? q_out_bits : cfg_out_bits;
+        src_relu     = promote ? q_relu     : cfg_relu;
+        src_batch    = promote ? q_batch    : cfg_batch;
+    end
+    
+    // Post-op parameter bank written by prm_wr_*; each started or
+    // queued layer takes the bank written so far and the next layer's
+    // parameters go to the other one
+    logic        prm_ld_bank;
+    
+    // Weight load descriptor handed to weight_buffer. Loaded from the cfg
+    // inputs when a layer starts or is queued, so the queued layer's weights
+    // stream in while the current layer runs.
+    logic [15:0] wl_IC, wl_OC;
+    logic [4:0]  wl_wgt_bits;
+    logic [4:0]  wl_act_bits;           // Sets the ic lane mapping on read
+    logic        wl_pending;
+    logic        wl_load;
+    logic        wl_issue;              // Descriptor taken by weight_buffer
 
     //========================================================================
     // Error Code Definitions (§4.3)
@@ -123,10 +271,12 @@ module conv3x3_accel_top #(
     localparam logic [3:0] ERR_STRIDE         = 4'd1;
     localparam logic [3:0] ERR_ACT_BITS       = 4'd2;
     localparam logic [3:0] ERR_WGT_BITS       = 4'd3;
-    localparam logic [3:0] ERR_MVP_RESTRICTION = 4'd4;
+    // 4'd4 was ERR_MVP_RESTRICTION (act_bits>2 && wgt_bits>2), now legal
     localparam logic [3:0] ERR_IC_ALIGN       = 4'd5;
     localparam logic [3:0] ERR_OC_ALIGN       = 4'd6;
     localparam logic [3:0] ERR_SIZE_EXCEED    = 4'd7;
+    localparam logic [3:0] ERR_OUT_BITS       = 4'd8;
+    localparam logic [3:0] ERR_TILE           = 4'd9;
 
     //========================================================================
     // Constraint Checking (§4.3)
@@ -137,8 +287,8 @@ module conv3x3_accel_top #(
     logic [3:0] check_error_code;
     
     always_comb begin
-        check_slices_act = calc_slices(cfg_act_bits);
-        check_slices_wgt = calc_slices(cfg_wgt_bits);
+        check_slices_act = calc_slices(src_act_bits);
+        check_slices_wgt = calc_slices(src_wgt_bits);
         check_ic_ch_per_cycle = IC2_LANES[4:0] / check_slices_act;
         check_oc_ch_per_cycle = OC2_LANES[4:0] / check_slices_wgt;
         
@@ -146,51 +296,62 @@ module conv3x3_accel_top #(
         check_error_code = ERR_NONE;
         
         // Check 1: stride ∈ {0,1}
-        if (!check_error && (cfg_stride !== 1'b0 && cfg_stride !== 1'b1)) begin
+        if (!check_error && (src_stride !== 1'b0 && src_stride !== 1'b1)) begin
             check_error = 1'b1;
             check_error_code = ERR_STRIDE;
         end
         
         // Check 2: act_bits ∈ {2,4,8,16}
         if (!check_error && 
-            !(cfg_act_bits == 5'd2 || cfg_act_bits == 5'd4 || 
-              cfg_act_bits == 5'd8 || cfg_act_bits == 5'd16)) begin
+            !(src_act_bits == 5'd2 || src_act_bits == 5'd4 || 
+              src_act_bits == 5'd8 || src_act_bits == 5'd16)) begin
             check_error = 1'b1;
             check_error_code = ERR_ACT_BITS;
         end
         
         // Check 3: wgt_bits ∈ {2,4,8,16}
         if (!check_error && 
-            !(cfg_wgt_bits == 5'd2 || cfg_wgt_bits == 5'd4 || 
-              cfg_wgt_bits == 5'd8 || cfg_wgt_bits == 5'd16)) begin
+            !(src_wgt_bits == 5'd2 || src_wgt_bits == 5'd4 || 
+              src_wgt_bits == 5'd8 || src_wgt_bits == 5'd16)) begin
             check_error = 1'b1;
             check_error_code = ERR_WGT_BITS;
         end
         
-        // Check 4: MVP restriction - not both > 2
-        if (!check_error && (cfg_act_bits > 5'd2 && cfg_wgt_bits > 5'd2)) begin
-            check_error = 1'b1;
-            check_error_code = ERR_MVP_RESTRICTION;
-        end
-        
         // Check 5: IC % IC_CH_PER_CYCLE == 0
-        if (!check_error && (cfg_IC % check_ic_ch_per_cycle) != 16'd0) begin
+        if (!check_error && (src_IC % check_ic_ch_per_cycle) != 16'd0) begin
             check_error = 1'b1;
             check_error_code = ERR_IC_ALIGN;
         end
         
         // Check 6: OC % OC_CH_PER_CYCLE == 0
-        if (!check_error && (cfg_OC % check_oc_ch_per_cycle) != 16'd0) begin
+        if (!check_error && (src_OC % check_oc_ch_per_cycle) != 16'd0) begin
             check_error = 1'b1;
             check_error_code = ERR_OC_ALIGN;
         end
         
-        // Check 7: Size limits
+        // Check 7: Size limits; with a column tile MAX_W bounds the tile
         if (!check_error && 
-            (cfg_W > MAX_W || cfg_H > MAX_H || cfg_IC > MAX_IC || cfg_OC > MAX_OC)) begin
+            ((src_tile_W == 16'd0 ? src_W : src_tile_W) > MAX_W ||
+             src_H > MAX_H || src_IC > MAX_IC || src_OC > MAX_OC)) begin
             check_error = 1'b1;
             check_error_code = ERR_SIZE_EXCEED;
         end
+        
+        // Check 8: out_bits ∈ {2,4,8,16} when requantizing
+        if (!check_error && !src_raw_out &&
+            !(src_out_bits == 5'd2 || src_out_bits == 5'd4 ||
+              src_out_bits == 5'd8 || src_out_bits == 5'd16)) begin
+            check_error = 1'b1;
+            check_error_code = ERR_OUT_BITS;
+        end
+        
+        // Check 9: the tile lies inside the layer and holds a whole window
+        if (!check_error && src_tile_W != 16'd0 &&
+            ({1'b0, src_tile_x0} + {1'b0, src_tile_W} > {1'b0, src_W} ||
+             calc_tile_ow(src_W, src_tile_x0, src_tile_W, src_stride, src_pad) == 16'd0)) begin
+            check_error = 1'b1;
+            check_error_code = ERR_TILE;
+        end
     end
 
     //========================================================================
@@ -203,6 +364,12 @@ module conv3x3_accel_top #(
             r_IC <= 16'd0;
             r_OC <= 16'd0;
             r_stride <= 1'b0;
+            r_pad <= 1'b0;
+            r_pad_use_code <= 1'b0;
+            r_pad_code <= 16'd0;
+            r_tile_x0 <= 16'd0;
+            r_tile_W <= 16'd0;
+            r_tile_ox0 <= 16'd0;
             r_act_bits <= 5'd0;
             r_wgt_bits <= 5'd0;
             r_act_slices <= 4'd0;
@@ -213,11 +380,15 @@ module conv3x3_accel_top #(
             r_num_oc_grp <= 8'd0;
             r_OH <= 16'd0;
             r_OW <= 16'd0;
+            r_out_bits <= 6'd32;
+            r_relu <= 1'b0;
+            r_batch <= 8'd1;
+            r_prm_bank <= 1'b0;
             config_valid <= 1'b0;
             config_error <= 1'b0;
             config_error_code <= ERR_NONE;
         end else begin
-            if (cfg_valid && cfg_ready) begin
+            if (cfg_load) begin
                 if (check_error) begin
                     // Configuration error
                     config_error <= 1'b1;
@@ -225,24 +396,39 @@ module conv3x3_accel_top #(
                     config_valid <= 1'b0;
                 end else begin
                     // Load valid configuration
-                    r_W <= cfg_W;
-                    r_H <= cfg_H;
-                    r_IC <= cfg_IC;
-                    r_OC <= cfg_OC;
-                    r_stride <= cfg_stride;
-                    r_act_bits <= cfg_act_bits;
-                    r_wgt_bits <= cfg_wgt_bits;
+                    r_W <= src_W;
+                    r_H <= src_H;
+                    r_IC <= src_IC;
+                    r_OC <= src_OC;
+                    r_stride <= src_stride;
+                    r_pad <= src_pad;
+                    r_pad_use_code <= src_pad_use_code;
+                    r_pad_code <= src_pad_code;
+                    r_tile_x0 <= src_tile_x0;
+                    r_tile_W <= src_tile_W;
+                    r_act_bits <= src_act_bits;
+                    r_wgt_bits <= src_wgt_bits;
                     
                     r_act_slices <= check_slices_act;
                     r_wgt_slices <= check_slices_wgt;
                     r_IC_CH_PER_CYCLE <= check_ic_ch_per_cycle;
                     r_OC_CH_PER_CYCLE <= check_oc_ch_per_cycle;
                     
-                    r_num_ic_grp <= cfg_IC[7:0] / check_ic_ch_per_cycle[7:0];
-                    r_num_oc_grp <= cfg_OC[7:0] / check_oc_ch_per_cycle[7:0];
+                    r_num_ic_grp <= 8'(src_IC / 16'(check_ic_ch_per_cycle));
+                    r_num_oc_grp <= 8'(src_OC / 16'(check_oc_ch_per_cycle));
                     
-                    r_OH <= calc_out_dim(cfg_H, cfg_stride);
-                    r_OW <= calc_out_dim(cfg_W, cfg_stride);
+                    r_OH <= calc_out_dim(src_H, src_stride, src_pad);
+                    if (src_tile_W == 16'd0) begin
+                        r_tile_ox0 <= 16'd0;
+                        r_OW <= calc_out_dim(src_W, src_stride, src_pad);
+                    end else begin
+                        r_tile_ox0 <= calc_tile_ox0(src_tile_x0, src_stride, src_pad);
+                        r_OW <= calc_tile_ow(src_W, src_tile_x0, src_tile_W, src_stride, src_pad);
+                    end
+                    r_out_bits <= src_raw_out ? 6'd32 : {1'b0, src_out_bits};
+                    r_relu <= src_relu;
+                    r_batch <= (src_batch == 8'd0) ? 8'd1 : src_batch;
+                    r_prm_bank <= promote ? q_prm_bank : prm_ld_bank;
                     
                     config_valid <= 1'b1;
                     config_error <= 1'b0;
@@ -255,6 +441,72 @@ module conv3x3_accel_top #(
             end
         end
     end
+    
+    // Queue slot and weight load descriptor
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            q_W <= 16'd0;
+            q_H <= 16'd0;
+            q_IC <= 16'd0;
+            q_OC <= 16'd0;
+            q_stride <= 1'b0;
+            q_pad <= 1'b0;
+            q_pad_use_code <= 1'b0;
+            q_pad_code <= 16'd0;
+            q_tile_x0 <= 16'd0;
+            q_tile_W <= 16'd0;
+            q_act_bits <= 5'd0;
+            q_wgt_bits <= 5'd0;
+            q_raw_out <= 1'b1;
+            q_out_bits <= 5'd0;
+            q_relu <= 1'b0;
+            q_batch <= 8'd1;
+            q_prm_bank <= 1'b0;
+            q_valid <= 1'b0;
+            prm_ld_bank <= 1'b0;
+            wl_IC <= 16'd0;
+            wl_OC <= 16'd0;
+            wl_wgt_bits <= 5'd0;
+            wl_act_bits <= 5'd0;
+            wl_pending <= 1'b0;
+        end else begin
+            if (cfg_queue) begin
+                q_W <= cfg_W;
+                q_H <= cfg_H;
+                q_IC <= cfg_IC;
+                q_OC <= cfg_OC;
+                q_stride <= cfg_stride;
+                q_pad <= cfg_pad;
+                q_pad_use_code <= cfg_pad_use_code;
+                q_pad_code <= cfg_pad_code;
+                q_tile_x0 <= cfg_tile_x0;
+                q_tile_W <= cfg_tile_W;
+                q_act_bits <= cfg_act_bits;
+                q_wgt_bits <= cfg_wgt_bits;
+                q_raw_out <= cfg_mode_raw_out;
+                q_out_bits <= cfg_out_bits;
+                q_relu <= cfg_relu;
+                q_batch <= cfg_batch;
+                q_prm_bank <= prm_ld_bank;
+                q_valid <= 1'b1;
+            end else if (promote) begin
+                q_valid <= 1'b0;
+            end
+            
+            if (wl_load)
+                prm_ld_bank <= !prm_ld_bank;
+            
+            if (wl_load) begin
+                wl_IC <= cfg_IC;
+                wl_OC <= cfg_OC;
+                wl_wgt_bits <= cfg_wgt_bits;
+                wl_act_bits <= cfg_act_bits;
+                wl_pending <= 1'b1;
+            end else if (wl_issue) begin
+                wl_pending <= 1'b0;
+            end
+        end
+    end
 
     //========================================================================
     // Top-Level FSM States (§5)
@@ -278,14 +530,39 @@ module conv3x3_accel_top #(
     //========================================================================
     // Convolution Control Variables
     //========================================================================
-    // Loop indices: oy -> ox -> oc_grp -> ic_grp
+    // Loop indices: image -> oy -> ox -> ic_grp -> oc_grp
+    logic [7:0]  loop_img;
     logic [15:0] loop_oy, loop_ox;
     logic [7:0]  loop_oc_grp, loop_ic_grp;
     
     // Loop control signals
     logic loop_advancing;
     logic ic_grp_done, oc_grp_done, ox_done, oy_done;
-    logic last_window;
+    logic last_window;                  // Last window of the current image
+    logic last_image;
+    logic loop_done;                    // Last window of the batch has been fired
+    
+    // Batch bookkeeping: line buffer starts still to be issued (one per
+    // image) and images whose last result has reached the packer
+    logic [7:0]  flb_img_left;
+    logic [7:0]  out_img_cnt;
+    logic        flb_cfg_valid;
+    
+    // Weight request issue: runs ahead of the loop counters so the
+    // weight_buffer read pipeline stays full (same ic_grp -> oc_grp order).
+    // req_remaining counts every block of the batch, so it is sized for
+    // MAX_BATCH * MAX_H * MAX_W * MAX_OC_GRP * MAX_IC_GRP (16-bit operands
+    // have the most groups); check 7 keeps every factor within its maximum.
+    localparam int MAX_BATCH  = 255;
+    localparam int MAX_OC_GRP = MAX_OC * 8 / OC2_LANES;
+    localparam int MAX_IC_GRP = MAX_IC * 8 / IC2_LANES;
+    localparam int REQ_CNT_W  = $clog2(MAX_BATCH + 1) + $clog2(MAX_H + 1) + $clog2(MAX_W + 1) +
+                                $clog2(MAX_OC_GRP + 1) + $clog2(MAX_IC_GRP + 1);
+    logic [7:0]  req_oc_grp, req_ic_grp;
+    logic [REQ_CNT_W-1:0] req_remaining;
+    
+    // Layer start: config accepted together with start in IDLE
+    logic layer_start;
     
     // Line buffer status
     logic linebuf_ready;
@@ -294,11 +571,21 @@ module conv3x3_accel_top #(
     //========================================================================
     // Inter-Cycle Accumulator (§5, accumulator in top)
     //========================================================================
-    // Accumulator buffer for OC_CH_PER_CYCLE output channels
-    // Stores partial sums across ic_grp iterations
+    // Partial sums of every output channel of the current pixel (oc_grp is
+    // the inner loop, so all groups are open until the last ic_grp), stored
+    // by physical channel c = oc_grp * OC_CH_PER_CYCLE + p: bank c % 16,
+    // address c / 16. OC_CH_PER_CYCLE divides 16, so a group is one row of
+    // consecutive banks and all 16 banks read the same address. Reads are
+    // registered (one read and one write port per bank) so it maps to RAM.
+    localparam int ACC_DEPTH = (MAX_OC + 15) / 16;
+    localparam int ACC_ADDR_W = $clog2(ACC_DEPTH);
+    logic signed [ACC_W-1:0] acc_mem [0:15][0:ACC_DEPTH-1];
+    
+    // Finished OC_CH_PER_CYCLE result waiting for the stub
     logic signed [ACC_W-1:0] acc_buf [0:15];  // Max 16 channels
     logic acc_valid;
     logic acc_last;
+    logic [7:0] acc_oc_grp;
     
     //========================================================================
     // Submodule Connections
@@ -311,11 +598,14 @@ module conv3x3_accel_top #(
     logic [15:0] flb_win_y, flb_win_x;
     logic [7:0]  flb_win_ic_grp;
     logic [1:0]  flb_win_act2 [0:2][0:2][0:IC2_LANES-1];
+    logic        flb_win_mask [0:2][0:2];
     
     // Weight Buffer connections
     logic        wbuf_cfg_ready;
     logic        wbuf_wgt_in_ready;
     logic        wbuf_load_done;
+    logic        wbuf_rd_ready;
+    logic        wbuf_rd_release;
     logic [7:0]  wbuf_req_oc_grp;
     logic [7:0]  wbuf_req_ic_grp;
     logic        wbuf_req_valid;
@@ -330,21 +620,26 @@ module conv3x3_accel_top #(
     logic        core_out_valid;
     logic        core_out_ready;
     logic signed [ACC_W-1:0] core_partial [0:OC2_LANES-1];
+    logic signed [ACC_W-1:0] core_lut_offset;
     
     // Other Ops Stub connections
     logic        stub_in_valid;
     logic        stub_in_ready;
-    logic signed [ACC_W-1:0] stub_in_data;
+    logic signed [ACC_W-1:0] stub_in_data [0:OC2_LANES-1];
+    logic [4:0]  stub_in_count;
+    logic [15:0] stub_in_oc_base;
     logic        stub_in_last;
     logic        stub_out_valid;
     logic        stub_out_ready;
-    logic signed [ACC_W-1:0] stub_out_data;
+    logic signed [ACC_W-1:0] stub_out_data [0:OC2_LANES-1];
+    logic [4:0]  stub_out_count;
     logic        stub_out_last;
     
     // Output Packer connections
     logic        packer_in_valid;
     logic        packer_in_ready;
-    logic signed [ACC_W-1:0] packer_in_data;
+    logic signed [ACC_W-1:0] packer_in_data [0:OC2_LANES-1];
+    logic [4:0]  packer_in_count;
     logic        packer_in_last;
 
     //========================================================================
@@ -371,30 +666,39 @@ module conv3x3_accel_top #(
             end
             
             ST_CFG_ERROR: begin
-                if (start)
+                // A queued layer already spent its start when it was queued
+                if (start || err_promoted)
                     next_state = ST_DONE;  // Go to done to report error
             end
             
             ST_LOAD_WGT: begin
-                // Wait for weight loading to complete
-                if (wbuf_load_done)
+                // Wait until this layer's weight buffer is full (immediate
+                // if it was loaded while the previous layer ran)
+                if (wbuf_rd_ready)
                     next_state = ST_LOAD_ACT_AND_CONV;
             end
             
             ST_LOAD_ACT_AND_CONV: begin
-                // Wait for line buffer to finish and all loops to complete
-                if (linebuf_done && loop_oy >= r_OH)
+                // Wait for the last window to be fired into the core
+                if (loop_done)
                     next_state = ST_DRAIN_OUT;
             end
             
             ST_DRAIN_OUT: begin
-                // Wait for output packer to drain
-                if (packer_in_last && packer_in_valid && packer_in_ready)
+                // Wait for the last image's final result to enter the packer
+                if (packer_in_last && packer_in_valid && packer_in_ready &&
+                    out_img_cnt + 8'd1 >= r_batch)
                     next_state = ST_DONE;
             end
             
             ST_DONE: begin
-                next_state = ST_IDLE;
+                // Launch a queued layer directly; it fails the same checks
+                // as a directly configured one and then reports its error
+                // through ST_CFG_ERROR -> ST_DONE without another start
+                if (q_valid)
+                    next_state = check_error ? ST_CFG_ERROR : ST_LOAD_WGT;
+                else
+                    next_state = ST_IDLE;
             end
             
             default: next_state = ST_IDLE;
@@ -405,8 +709,41 @@ module conv3x3_accel_top #(
     // FSM Output Logic and Control
     //========================================================================
     
-    // cfg_ready: Accept config only in IDLE
-    assign cfg_ready = (state == ST_IDLE);
+    // cfg_ready: Accept config in IDLE, or into the queue slot while a
+    // layer is running (one queued layer, weight descriptor handed off).
+    // Only a config presented with start can be queued, so without start
+    // the handshake is held off instead of dropping the config.
+    assign cfg_ready = !wl_pending &&
+                       ((state == ST_IDLE) ||
+                        (start && !q_valid && (state == ST_LOAD_WGT ||
+                                               state == ST_LOAD_ACT_AND_CONV ||
+                                               state == ST_DRAIN_OUT)));
+    
+    // Parameter writes wait while their bank is still read by the running
+    // layer (a layer is running and another one is already queued)
+    assign prm_wr_ready = !(r_prm_bank == prm_ld_bank &&
+                            (state == ST_LOAD_WGT || state == ST_LOAD_ACT_AND_CONV ||
+                             state == ST_DRAIN_OUT));
+    
+    assign cfg_load  = ((state == ST_IDLE) && cfg_valid && cfg_ready) || promote;
+    assign cfg_queue = (state != ST_IDLE) && cfg_valid && cfg_ready && start;
+    assign promote   = (state == ST_DONE) && q_valid;
+    
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n)
+            err_promoted <= 1'b0;
+        else if (promote)
+            err_promoted <= check_error;
+        else if (state != ST_CFG_ERROR)
+            err_promoted <= 1'b0;
+    end
+    
+    // Weights are loaded only for layers that pass the checks
+    assign wl_load = cfg_valid && cfg_ready && start && !check_error;
+    
+    assign layer_start = ((state == ST_IDLE) && cfg_valid && cfg_ready &&
+                          !check_error && start) ||
+                         (promote && !check_error);
     
     // done: Assert in DONE state
     assign done = (state == ST_DONE);
@@ -417,11 +754,15 @@ module conv3x3_accel_top #(
     //========================================================================
     // Weight Loading Control
     //========================================================================
-    assign wgt_in_ready = (state == ST_LOAD_WGT) ? wbuf_wgt_in_ready : 1'b0;
+    // Not gated by state: a queued layer's weights may stream in while the
+    // current layer is in ST_LOAD_ACT_AND_CONV / ST_DRAIN_OUT
+    assign wgt_in_ready = wbuf_wgt_in_ready;
+    
+    assign wl_issue = wl_pending && wbuf_cfg_ready;
 
     //========================================================================
     // Convolution Loop Control (§5)
-    // Loop order: oy -> ox -> oc_grp -> ic_grp
+    // Loop order: oy -> ox -> ic_grp -> oc_grp
     //========================================================================
     
     // Advance condition: current window processed by conv core
@@ -434,37 +775,45 @@ module conv3x3_accel_top #(
     assign oc_grp_done = (loop_oc_grp + 8'd1 >= r_num_oc_grp);
     assign ox_done = (loop_ox + 16'd1 >= r_OW);
     assign oy_done = (loop_oy + 16'd1 >= r_OH);
-    assign last_window = oy_done && ox_done && oc_grp_done && ic_grp_done;
+    assign last_window = oy_done && ox_done && ic_grp_done && oc_grp_done;
+    assign last_image = (loop_img + 8'd1 >= r_batch);
     
     // Loop counters
     always_ff @(posedge clk or negedge rst_n) begin
         if (!rst_n) begin
+            loop_img <= 8'd0;
             loop_oy <= 16'd0;
             loop_ox <= 16'd0;
             loop_oc_grp <= 8'd0;
             loop_ic_grp <= 8'd0;
+            loop_done <= 1'b0;
         end else begin
             case (state)
                 ST_IDLE, ST_LOAD_WGT: begin
+                    loop_img <= 8'd0;
                     loop_oy <= 16'd0;
                     loop_ox <= 16'd0;
                     loop_oc_grp <= 8'd0;
                     loop_ic_grp <= 8'd0;
+                    loop_done <= 1'b0;
                 end
                 
                 ST_LOAD_ACT_AND_CONV: begin
+                    if (loop_advancing && last_window && last_image) begin
+                        loop_done <= 1'b1;
+                    end
                     if (loop_advancing) begin
-                        // Advance ic_grp first
-                        if (!ic_grp_done) begin
-                            loop_ic_grp <= loop_ic_grp + 8'd1;
+                        // Advance oc_grp first: the window stays put
+                        if (!oc_grp_done) begin
+                            loop_oc_grp <= loop_oc_grp + 8'd1;
                         end else begin
-                            loop_ic_grp <= 8'd0;
+                            loop_oc_grp <= 8'd0;
                             
-                            // Then oc_grp
-                            if (!oc_grp_done) begin
-                                loop_oc_grp <= loop_oc_grp + 8'd1;
+                            // Then ic_grp (next window)
+                            if (!ic_grp_done) begin
+                                loop_ic_grp <= loop_ic_grp + 8'd1;
                             end else begin
-                                loop_oc_grp <= 8'd0;
+                                loop_ic_grp <= 8'd0;
                                 
                                 // Then ox
                                 if (!ox_done) begin
@@ -472,9 +821,13 @@ module conv3x3_accel_top #(
                                 end else begin
                                     loop_ox <= 16'd0;
                                     
-                                    // Finally oy
+                                    // Then oy
                                     if (!oy_done) begin
                                         loop_oy <= loop_oy + 16'd1;
+                                    end else if (!last_image) begin
+                                        // Next image of the batch
+                                        loop_oy <= 16'd0;
+                                        loop_img <= loop_img + 8'd1;
                                     end
                                 end
                             end
@@ -490,39 +843,204 @@ module conv3x3_accel_top #(
     //========================================================================
     // Feature Line Buffer Interface
     //========================================================================
+    // The window of (oy, ox, ic_grp) is held while all OC groups fire on
+    // it and is consumed with the last one, so each window is read from
+    // the line buffer once per pixel instead of once per OC group
     assign flb_win_ready = (state == ST_LOAD_ACT_AND_CONV) && 
-                           wbuf_wgt_valid && core_in_ready;
+                           wbuf_wgt_valid && core_in_ready && oc_grp_done;
+    
+    // The line buffer runs one image per configuration. It is started once
+    // per image of the batch: the first start overlaps ST_LOAD_WGT, the
+    // following ones happen as soon as it returns to idle after an image.
+    // The weight buffer is not touched in between.
+    assign flb_cfg_valid = config_valid && (flb_img_left != 8'd0) &&
+                           (state == ST_LOAD_WGT || state == ST_LOAD_ACT_AND_CONV);
+    
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            flb_img_left <= 8'd0;
+            out_img_cnt <= 8'd0;
+        end else begin
+            if (cfg_load)
+                flb_img_left <= (src_batch == 8'd0) ? 8'd1 : src_batch;
+            else if (flb_cfg_valid && flb_cfg_ready)
+                flb_img_left <= flb_img_left - 8'd1;
+            
+            if (layer_start)
+                out_img_cnt <= 8'd0;
+            else if (packer_in_last && packer_in_valid && packer_in_ready)
+                out_img_cnt <= out_img_cnt + 8'd1;
+        end
+    end
 
     //========================================================================
     // Weight Buffer Request Interface
+    // Weight blocks depend only on (oc_grp, ic_grp), so requests are issued
+    // independently of window availability, one per cycle, and queue in the
+    // weight_buffer read pipeline until the matching window fires.
     //========================================================================
-    assign wbuf_req_oc_grp = loop_oc_grp;
-    assign wbuf_req_ic_grp = loop_ic_grp;
-    assign wbuf_req_valid = (state == ST_LOAD_ACT_AND_CONV) && flb_win_valid;
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            req_oc_grp <= 8'd0;
+            req_ic_grp <= 8'd0;
+            req_remaining <= '0;
+        end else begin
+            case (state)
+                ST_IDLE, ST_LOAD_WGT: begin
+                    req_oc_grp <= 8'd0;
+                    req_ic_grp <= 8'd0;
+                    req_remaining <= REQ_CNT_W'(r_batch) * REQ_CNT_W'(r_OH) * REQ_CNT_W'(r_OW) *
+                                     REQ_CNT_W'(r_num_oc_grp) * REQ_CNT_W'(r_num_ic_grp);
+                end
+                
+                ST_LOAD_ACT_AND_CONV: begin
+                    if (wbuf_req_valid && wbuf_req_ready) begin
+                        req_remaining <= req_remaining - 1'b1;
+                        if (req_oc_grp + 8'd1 < r_num_oc_grp) begin
+                            req_oc_grp <= req_oc_grp + 8'd1;
+                        end else begin
+                            req_oc_grp <= 8'd0;
+                            if (req_ic_grp + 8'd1 < r_num_ic_grp)
+                                req_ic_grp <= req_ic_grp + 8'd1;
+                            else
+                                req_ic_grp <= 8'd0;
+                        end
+                    end
+                end
+                
+                default: ; // Hold values
+            endcase
+        end
+    end
+    
+    assign wbuf_req_oc_grp = req_oc_grp;
+    assign wbuf_req_ic_grp = req_ic_grp;
+    assign wbuf_req_valid = (state == ST_LOAD_ACT_AND_CONV) && (req_remaining != '0);
     assign wbuf_wgt_ready = (state == ST_LOAD_ACT_AND_CONV) && 
                             flb_win_valid && core_in_ready;
+    // All blocks of this layer have been consumed once the last window of
+    // the last image fires: hand the buffer back so the next layer's weights can use it
+    assign wbuf_rd_release = (state == ST_LOAD_ACT_AND_CONV) && loop_done;
 
     //========================================================================
     // Conv Core Input Interface
     //========================================================================
     assign core_in_valid = (state == ST_LOAD_ACT_AND_CONV) && 
                            flb_win_valid && wbuf_wgt_valid;
-    assign core_out_ready = 1'b1;  // Always ready to accept core output
 
     //========================================================================
     // Inter-Cycle Accumulator Logic (§5)
-    // Accumulate partial results across ic_grp for same (oy, ox, oc_grp)
+    // Accumulate partial results across ic_grp for same (oy, ox, oc_grp).
+    // Earlier ic_grps update the group's channels in acc_mem; the last one
+    // adds its partial to them and hands the sum to the stub through acc_buf.
     //========================================================================
     
-    // Determine if this is the first or last ic_grp for current window
+    // Determine if this is the first or last ic_grp for current window.
+    // The loop counters advance on the fire, so the flags go through the
+    // conv_core pipeline as the tag of the window and come out with its
+    // partial sums, whatever PIPE_STAGES is.
+    localparam int CORE_TAG_W = 11;
+    
+    logic [CORE_TAG_W-1:0] core_in_tag, core_out_tag;
     logic is_first_ic_grp;
     logic is_last_ic_grp;
+    logic core_last_window;
+    logic [7:0] core_oc_grp;
     
-    assign is_first_ic_grp = (loop_ic_grp == 8'd0);
-    assign is_last_ic_grp = (loop_ic_grp + 8'd1 >= r_num_ic_grp);
+    assign core_in_tag = {loop_ic_grp == 8'd0, ic_grp_done, last_window, loop_oc_grp};
+    assign {is_first_ic_grp, is_last_ic_grp, core_last_window, core_oc_grp} = core_out_tag;
     
     // Accumulator update
     logic signed [ACC_W-1:0] acc_result [0:15];
+    logic signed [ACC_W-1:0] acc_sum [0:15];
+    
+    // Every core partial carries the constant core_lut_offset of the layer's
+    // bit widths; num_ic_grp partials make one output, so the first ic_grp
+    // starts from -num_ic_grp * offset instead of 0. The operands are
+    // layer constants and the first window reaches the accumulator long
+    // after they load, so the product is simply registered.
+    logic signed [ACC_W-1:0] r_acc_bias;
+    
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n)
+            r_acc_bias <= '0;
+        else
+            r_acc_bias <= -(core_lut_offset * ACC_W'(r_num_ic_grp));
+    end
+    
+    // Read stage X: a core output enters X together with the acc_mem read
+    // of its group's row and leaves it adding the partial to that total.
+    // With a single OC group the item leaving X writes the row the entering
+    // one reads in the same cycle; its sum is forwarded instead.
+    logic                    x_valid, x_first, x_last, x_last_window;
+    logic [7:0]              x_oc_grp;
+    logic signed [ACC_W-1:0] x_partial [0:15];
+    logic signed [ACC_W-1:0] x_rd [0:15];       // acc_mem row, bank order
+    logic                    x_fwd;
+    logic signed [ACC_W-1:0] x_fwd_val [0:15];  // Forwarded sum, lane order
+    logic                    x_enter, x_exit;
+    logic [ACC_ADDR_W-1:0]   core_acc_addr, x_acc_addr;
+    logic [3:0]              x_acc_rot;         // Bank of the group's channel 0
+    
+    assign core_acc_addr = ACC_ADDR_W'((16'(core_oc_grp) * 16'(r_OC_CH_PER_CYCLE)) >> 4);
+    assign x_acc_addr    = ACC_ADDR_W'((16'(x_oc_grp) * 16'(r_OC_CH_PER_CYCLE)) >> 4);
+    assign x_acc_rot     = 4'(16'(x_oc_grp) * 16'(r_OC_CH_PER_CYCLE));
+    
+    // Only a finished sum needs acc_buf: hold it in X while the previous
+    // one is still waiting for the stub
+    assign x_exit = x_valid && (!x_last || !acc_valid || stub_in_ready);
+    assign core_out_ready = !x_valid || x_exit;
+    assign x_enter = core_out_valid && core_out_ready;
+    
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            x_valid <= 1'b0;
+            x_first <= 1'b0;
+            x_last <= 1'b0;
+            x_last_window <= 1'b0;
+            x_oc_grp <= 8'd0;
+            x_fwd <= 1'b0;
+        end else begin
+            if (x_enter) begin
+                x_valid <= 1'b1;
+                x_first <= is_first_ic_grp;
+                x_last <= is_last_ic_grp;
+                x_last_window <= core_last_window;
+                x_oc_grp <= core_oc_grp;
+                x_fwd <= x_exit && !x_last && x_oc_grp == core_oc_grp;
+            end else if (x_exit) begin
+                x_valid <= 1'b0;
+            end
+        end
+    end
+    
+    always_ff @(posedge clk) begin
+        if (x_enter) begin
+            for (int i = 0; i < 16; i++) begin
+                x_partial[i] <= core_partial[i];
+                x_rd[i] <= acc_mem[i][core_acc_addr];
+                x_fwd_val[i] <= acc_sum[i];
+            end
+        end
+    end
+    
+    // Sum of the core partial and the group's running total
+    always_comb begin
+        for (int i = 0; i < 16; i++)
+            acc_sum[i] = (x_first ? r_acc_bias :
+                          x_fwd   ? x_fwd_val[i] : x_rd[4'(x_acc_rot + 4'(i))]) +
+                         x_partial[i];
+    end
+    
+    // Running totals (no reset needed: the first ic_grp overwrites)
+    always_ff @(posedge clk) begin
+        if (x_exit && !x_last) begin
+            for (int b = 0; b < 16; b++) begin
+                if (4'(4'(b) - x_acc_rot) < r_OC_CH_PER_CYCLE)
+                    acc_mem[b][x_acc_addr] <= acc_sum[4'(4'(b) - x_acc_rot)];
+            end
+        end
+    end
     
     always_ff @(posedge clk or negedge rst_n) begin
         if (!rst_n) begin
@@ -531,27 +1049,21 @@ module conv3x3_accel_top #(
             end
             acc_valid <= 1'b0;
             acc_last <= 1'b0;
+            acc_oc_grp <= 8'd0;
         end else begin
-            acc_valid <= 1'b0;
+            // acc_valid holds until the stub takes the result
+            if (acc_valid && stub_in_ready)
+                acc_valid <= 1'b0;
             
-            if (core_out_valid) begin
+            // Output valid when last ic_grp is processed
+            if (x_exit && x_last) begin
                 for (int i = 0; i < 16; i++) begin
-                    if (i < r_OC_CH_PER_CYCLE) begin
-                        if (is_first_ic_grp) begin
-                            // First ic_grp: initialize accumulator
-                            acc_buf[i] <= core_partial[i];
-                        end else begin
-                            // Subsequent ic_grp: accumulate
-                            acc_buf[i] <= acc_buf[i] + core_partial[i];
-                        end
-                    end
-                end
-                
-                // Output valid when last ic_grp is processed
-                if (is_last_ic_grp) begin
-                    acc_valid <= 1'b1;
-                    acc_last <= last_window;
+                    if (i < r_OC_CH_PER_CYCLE)
+                        acc_buf[i] <= acc_sum[i];
                 end
+                acc_valid <= 1'b1;
+                acc_last <= x_last_window;
+                acc_oc_grp <= x_oc_grp;
             end
         end
     end
@@ -568,36 +1080,15 @@ module conv3x3_accel_top #(
     end
 
     //========================================================================
-    // Output Serialization (Convert parallel OC_CH_PER_CYCLE to serial)
+    // Accumulator -> Other Ops Stub
+    // The whole OC_CH_PER_CYCLE result moves as one vector; the packer splits
+    // it into BUS_W beats.
     //========================================================================
-    logic [3:0] out_serial_cnt;
-    logic out_serial_active;
-    
-    always_ff @(posedge clk or negedge rst_n) begin
-        if (!rst_n) begin
-            out_serial_cnt <= 4'd0;
-            out_serial_active <= 1'b0;
-        end else begin
-            if (acc_valid && !out_serial_active) begin
-                // Start serialization
-                out_serial_active <= 1'b1;
-                out_serial_cnt <= 4'd0;
-            end else if (out_serial_active && stub_in_ready) begin
-                // Advance serialization
-                if (out_serial_cnt + 4'd1 < r_OC_CH_PER_CYCLE) begin
-                    out_serial_cnt <= out_serial_cnt + 4'd1;
-                end else begin
-                    out_serial_active <= 1'b0;
-                end
-            end
-        end
-    end
-    
-    // Stub input (serialized)
-    assign stub_in_valid = out_serial_active;
-    assign stub_in_data = acc_result[out_serial_cnt];
-    assign stub_in_last = acc_last && out_serial_active && 
-                          (out_serial_cnt + 4'd1 >= r_OC_CH_PER_CYCLE);
+    assign stub_in_valid = acc_valid;
+    assign stub_in_data  = acc_result;
+    assign stub_in_count = r_OC_CH_PER_CYCLE;
+    assign stub_in_last  = acc_last;
+    assign stub_in_oc_base = 16'(acc_oc_grp) * 16'(r_OC_CH_PER_CYCLE);
 
     //========================================================================
     // Other Ops Stub -> Output Packer
@@ -605,6 +1096,7 @@ module conv3x3_accel_top #(
     assign stub_out_ready = packer_in_ready;
     assign packer_in_valid = stub_out_valid;
     assign packer_in_data = stub_out_data;
+    assign packer_in_count = stub_out_count;
     assign packer_in_last = stub_out_last;
 
     //========================================================================
@@ -630,7 +1122,12 @@ module conv3x3_accel_top #(
         .cfg_IC(r_IC),
         .cfg_act_bits(r_act_bits),
         .cfg_stride(r_stride),
-        .cfg_valid(config_valid && (state == ST_IDLE || state == ST_LOAD_WGT)),
+        .cfg_pad(r_pad),
+        .cfg_pad_use_code(r_pad_use_code),
+        .cfg_pad_code(r_pad_code),
+        .cfg_tile_x0(r_tile_x0),
+        .cfg_tile_W(r_tile_W),
+        .cfg_valid(flb_cfg_valid),
         .cfg_ready(flb_cfg_ready),
         
         // Activation input stream
@@ -646,6 +1143,7 @@ module conv3x3_accel_top #(
         .win_x(flb_win_x),
         .win_ic_grp(flb_win_ic_grp),
         .win_act2(flb_win_act2),
+        .win_mask(flb_win_mask),
         
         // Status
         .linebuf_ready(linebuf_ready),
@@ -662,16 +1160,18 @@ module conv3x3_accel_top #(
         .IC2_LANES(IC2_LANES),
         .OC2_LANES(OC2_LANES),
         .KH(KH),
-        .KW(KW)
+        .KW(KW),
+        .PINGPONG(WGT_PINGPONG)
     ) u_weight_buffer (
         .clk(clk),
         .rst_n(rst_n),
         
         // Config
-        .cfg_IC(r_IC),
-        .cfg_OC(r_OC),
-        .cfg_wgt_bits(r_wgt_bits),
-        .cfg_valid(config_valid && (state == ST_IDLE)),
+        .cfg_IC(wl_IC),
+        .cfg_OC(wl_OC),
+        .cfg_wgt_bits(wl_wgt_bits),
+        .cfg_act_bits(wl_act_bits),
+        .cfg_valid(wl_pending),
         .cfg_ready(wbuf_cfg_ready),
         
         // Weight input stream
@@ -680,6 +1180,8 @@ module conv3x3_accel_top #(
         .wgt_in_data(wgt_in_data),
         .wgt_in_last(wgt_in_last),
         .wgt_load_done(wbuf_load_done),
+        .rd_buf_ready(wbuf_rd_ready),
+        .rd_release(wbuf_rd_release),
         
         // Request interface
         .req_oc_grp(wbuf_req_oc_grp),
@@ -701,7 +1203,9 @@ module conv3x3_accel_top #(
         .OC2_LANES(OC2_LANES),
         .KH(KH),
         .KW(KW),
-        .ACC_W(ACC_W)
+        .ACC_W(ACC_W),
+        .PIPE_STAGES(PIPE_STAGES),
+        .TAG_W(CORE_TAG_W)
     ) u_conv_core_lowbit (
         .clk(clk),
         .rst_n(rst_n),
@@ -710,34 +1214,54 @@ module conv3x3_accel_top #(
         .in_valid(core_in_valid),
         .in_ready(core_in_ready),
         .act2(flb_win_act2),
+        .act_mask(flb_win_mask),
         .wgt2(wbuf_wgt2),
         .act_bits(r_act_bits),
         .wgt_bits(r_wgt_bits),
+        .in_tag(core_in_tag),
         
         // Output
         .out_valid(core_out_valid),
         .out_ready(core_out_ready),
-        .partial(core_partial)
+        .partial(core_partial),
+        .out_tag(core_out_tag),
+        .lut_offset(core_lut_offset)
     );
 
     //----------------------------------------------------------------------
-    // Other Ops Stub (MVP: pass-through)
+    // Other Ops Stub (bias / BN fold / ReLU / requantization)
     //----------------------------------------------------------------------
     other_ops_stub #(
         .ACC_W(ACC_W),
-        .OUT_BITS(ACC_W)
+        .OUT_BITS(ACC_W),
+        .LANES(OC2_LANES),
+        .CNT_W(5),
+        .MAX_OC(MAX_OC)
     ) u_other_ops_stub (
         .clk(clk),
         .rst_n(rst_n),
         
+        .cfg_out_bits(r_out_bits),
+        .cfg_relu(r_relu),
+        .prm_rd_bank(r_prm_bank),
+        .prm_wr_valid(prm_wr_valid && prm_wr_ready),
+        .prm_wr_bank(prm_ld_bank),
+        .prm_wr_oc(prm_wr_oc),
+        .prm_wr_bias(prm_wr_bias),
+        .prm_wr_scale(prm_wr_scale),
+        .prm_wr_shift(prm_wr_shift),
+        
         .in_valid(stub_in_valid),
         .in_ready(stub_in_ready),
         .in_data(stub_in_data),
+        .in_count(stub_in_count),
+        .in_oc_base(stub_in_oc_base),
         .in_last(stub_in_last),
         
         .out_valid(stub_out_valid),
         .out_ready(stub_out_ready),
         .out_data(stub_out_data),
+        .out_count(stub_out_count),
         .out_last(stub_out_last)
     );
 
@@ -746,15 +1270,20 @@ module conv3x3_accel_top #(
     //----------------------------------------------------------------------
     output_packer #(
         .ACC_W(ACC_W),
-        .BUS_W(BUS_W)
+        .BUS_W(BUS_W),
+        .LANES(OC2_LANES),
+        .CNT_W(5)
     ) u_output_packer (
         .clk(clk),
         .rst_n(rst_n),
         
+        .cfg_out_bits(r_out_bits),
+        
         // Input from stub
         .in_valid(packer_in_valid),
         .in_ready(packer_in_ready),
         .in_data(packer_in_data),
+        .in_count(packer_in_count),
         .in_last(packer_in_last),
         
         // Output to external stream
@@ -764,6 +1293,67 @@ module conv3x3_accel_top #(
         .out_last(out_last)
     );
 
+    //========================================================================
+    // Performance Counters
+    // Each cycle is attributed to at most one of win/wgt stall in the conv
+    // state (window first); stub and out stalls are separate back-pressure
+    // points. perf_core_burst tracks the longest run of consecutive fires.
+    //========================================================================
+    logic [31:0] perf_core_run;
+    
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            perf_cyc_total    <= 32'd0;
+            perf_cyc_load_wgt <= 32'd0;
+            perf_cyc_conv     <= 32'd0;
+            perf_cyc_drain    <= 32'd0;
+            perf_core_fire    <= 32'd0;
+            perf_stall_win    <= 32'd0;
+            perf_stall_wgt    <= 32'd0;
+            perf_stall_stub   <= 32'd0;
+            perf_stall_out    <= 32'd0;
+            perf_core_burst   <= 32'd0;
+            perf_core_run     <= 32'd0;
+        end else if (layer_start) begin
+            perf_cyc_total    <= 32'd0;
+            perf_cyc_load_wgt <= 32'd0;
+            perf_cyc_conv     <= 32'd0;
+            perf_cyc_drain    <= 32'd0;
+            perf_core_fire    <= 32'd0;
+            perf_stall_win    <= 32'd0;
+            perf_stall_wgt    <= 32'd0;
+            perf_stall_stub   <= 32'd0;
+            perf_stall_out    <= 32'd0;
+            perf_core_burst   <= 32'd0;
+            perf_core_run     <= 32'd0;
+        end else begin
+            if (state == ST_LOAD_WGT || state == ST_LOAD_ACT_AND_CONV || state == ST_DRAIN_OUT)
+                perf_cyc_total <= perf_cyc_total + 32'd1;
+            if (state == ST_LOAD_WGT)
+                perf_cyc_load_wgt <= perf_cyc_load_wgt + 32'd1;
+            if (state == ST_LOAD_ACT_AND_CONV)
+                perf_cyc_conv <= perf_cyc_conv + 32'd1;
+            if (state == ST_DRAIN_OUT)
+                perf_cyc_drain <= perf_cyc_drain + 32'd1;
+            if (core_in_valid && core_in_ready) begin
+                perf_core_fire <= perf_core_fire + 32'd1;
+                perf_core_run  <= perf_core_run + 32'd1;
+                if (perf_core_run + 32'd1 > perf_core_burst)
+                    perf_core_burst <= perf_core_run + 32'd1;
+            end else begin
+                perf_core_run  <= 32'd0;
+            end
+            if (state == ST_LOAD_ACT_AND_CONV && !flb_win_valid)
+                perf_stall_win <= perf_stall_win + 32'd1;
+            if (state == ST_LOAD_ACT_AND_CONV && flb_win_valid && !wbuf_wgt_valid)
+                perf_stall_wgt <= perf_stall_wgt + 32'd1;
+            if (stub_in_valid && !stub_in_ready)
+                perf_stall_stub <= perf_stall_stub + 32'd1;
+            if (out_valid && !out_ready)
+                perf_stall_out <= perf_stall_out + 32'd1;
+        end
+    end
+
     //========================================================================
     // Simulation Assertions
     //========================================================================
@@ -779,10 +1369,24 @@ module conv3x3_accel_top #(
         always @(posedge clk) begin
             if (state == ST_LOAD_ACT_AND_CONV && loop_advancing) begin
                 // Verify line buffer coordinates match loop counters
-                if (flb_win_y != loop_oy || flb_win_x != loop_ox)
+                if (flb_win_y != loop_oy || flb_win_x != r_tile_ox0 + loop_ox ||
+                    flb_win_ic_grp != loop_ic_grp)
                     $error("[conv3x3_accel_top] Window coordinate mismatch! ");
             end
         end
+        
+        initial begin
+            if (PIPE_STAGES < 1 || PIPE_STAGES > 4)
+                $error("[conv3x3_accel_top] PIPE_STAGES must be 1..4, got %0d", PIPE_STAGES);
+        end
+        
+        // The weight request count of a layer must fit req_remaining
+        always @(posedge clk) begin
+            if (state == ST_LOAD_WGT &&
+                64'(r_batch) * 64'(r_OH) * 64'(r_OW) * 64'(r_num_oc_grp) * 64'(r_num_ic_grp) >=
+                (64'd1 << REQ_CNT_W))
+                $error("[conv3x3_accel_top] Weight request count overflows REQ_CNT_W=%0d", REQ_CNT_W);
+        end
     `endif
 
 endmodule
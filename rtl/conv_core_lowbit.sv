@@ -2,6 +2,8 @@
 // conv_core_lowbit.sv
 // 低比特卷积核心计算模块
 // 支持 2/4/8/16-bit activation 和 weight，使用 LUT 乘法 + 无符号加法树
+// 加法树可按 PIPE_STAGES 插入流水寄存器 (valid/ready 逐级握手)
+// LUT 的 offset 不在 lane 内扣除，合并为常数 lut_offset 由累加器一次扣除
 //=============================================================================
 
 module conv_core_lowbit #(
@@ -9,7 +11,9 @@ module conv_core_lowbit #(
     parameter int OC2_LANES = 16,
     parameter int KH = 3,
     parameter int KW = 3,
-    parameter int ACC_W = 32
+    parameter int ACC_W = 32,
+    parameter int PIPE_STAGES = 1,      // 1..4 级寄存器，延迟 = PIPE_STAGES 拍
+    parameter int TAG_W = 1             // in_tag -> out_tag 随数据传递的旁路信息
 )(
     input  logic                      clk,
     input  logic                      rst_n,
@@ -18,14 +22,18 @@ module conv_core_lowbit #(
     input  logic                      in_valid,
     output logic                      in_ready,
     input  logic [1:0]                act2 [0:KH-1][0:KW-1][0:IC2_LANES-1],
+    input  logic                      act_mask [0:KH-1][0:KW-1],  // 0: 该 tap 贡献为 0 (padding)
     input  logic [1:0]                wgt2 [0:OC2_LANES-1][0:KH-1][0:KW-1][0:IC2_LANES-1],
     input  logic [4:0]                act_bits,      // 2, 4, 8, 16
     input  logic [4:0]                wgt_bits,      // 2, 4, 8, 16
+    input  logic [TAG_W-1:0]          in_tag,
     
     // 输出接口
     output logic                      out_valid,
     input  logic                      out_ready,
-    output logic signed [ACC_W-1:0]   partial [0:OC2_LANES-1]
+    output logic signed [ACC_W-1:0]   partial [0:OC2_LANES-1],
+    output logic [TAG_W-1:0]          out_tag,
+    output logic signed [ACC_W-1:0]   lut_offset     // partial = 真实值 + lut_offset
 );
 
     //=========================================================================
@@ -52,14 +60,14 @@ module conv_core_lowbit #(
     // 计算 slice 数量 (每 2-bit 一个 slice)
     //=========================================================================
     logic [3:0] act_slices, wgt_slices;
-    logic [3:0] ic_lanes_per_slice;
-    logic [3:0] oc_lanes_per_slice;
+    logic [4:0] ic_lanes_per_slice;     // 16 需要 5 位
+    logic [4:0] oc_lanes_per_slice;
     
     always_comb begin
         act_slices = act_bits[4:1];  // act_bits / 2
         wgt_slices = wgt_bits[4:1];  // wgt_bits / 2
-        ic_lanes_per_slice = IC2_LANES[4:0] / act_slices;
-        oc_lanes_per_slice = OC2_LANES[4:0] / wgt_slices;
+        ic_lanes_per_slice = 5'(IC2_LANES / act_slices);
+        oc_lanes_per_slice = 5'(OC2_LANES / wgt_slices);
     end
 
     //=========================================================================
@@ -67,13 +75,6 @@ module conv_core_lowbit #(
     // 每对产生一个 5-bit 无符号输出 (0-18)
     //=========================================================================
     
-    // 计算每 slice 的 pair 数量
-    // N_PAIRS = KH * KW * (ic_lanes_per_slice / 2)
-    logic [7:0] n_pairs;
-    always_comb begin
-        n_pairs = (KH * KW * ic_lanes_per_slice) >> 1;
-    end
-    
     // LUT 输出数组
     // lut_out[oc_lane][kh][kw][pair_idx]
     localparam int MAX_PAIRS_PER_SLICE = (KH * KW * IC2_LANES) >> 1; // 3*3*8 = 72 max
@@ -107,7 +108,8 @@ module conv_core_lowbit #(
                             .out_data(lut_out_wire)
                         );
                         
-                        assign lut_out[oc][kh][kw][pair] = lut_out_wire;
+                        // 被屏蔽的 tap 输出中性值 9 (pair_sum = 0)，去 offset 后正好为 0
+                        assign lut_out[oc][kh][kw][pair] = act_mask[kh][kw] ? lut_out_wire : 5'd9;
                     end
                 end
             end
@@ -115,148 +117,296 @@ module conv_core_lowbit #(
     endgenerate
 
     //=========================================================================
-    // unsigned reduction tree - 对每个 oc_lane、每个 slice 进行累加
+    // 流水线划分
+    //
+    // 归约分为四段，每段内部都是平衡二叉加法树:
+    //   A: LUT + 9 个 tap 求和      -> tap_sum[oc][pair]       (4 级加法)
+    //   B: pair 分段求和            -> slice_sum[oc][act_slice] (3 级)
+    //   C: act slice 合并            -> act_merged[oc]          (3 级)
+    //   D: wgt slice 合并           -> partial_reg              (3 级)
+    // D 之后的输出寄存器总是存在；PIPE_STAGES 决定 A/B/C 之后是否再插寄存器:
+    //   1: 无 (与原先单拍相同)   2: B 之后   3: A、C 之后   4: A、B、C 之后
+    // 每级寄存器在为空或下一级可接收时装载，满流水时每拍接收一个窗口，
+    // 延迟为 PIPE_STAGES 拍。in_tag 随数据逐级传递，供调用方对齐元数据。
+    // act_bits / wgt_bits 不随流水传递：上层保证换层前流水线已排空。
     //=========================================================================
+    localparam bit REG_A = (PIPE_STAGES >= 3);
+    localparam bit REG_B = (PIPE_STAGES == 2) || (PIPE_STAGES >= 4);
+    localparam bit REG_C = (PIPE_STAGES >= 3);
     
-    // 中间结果: sum_u[oc_lane][act_slice] - 无符号累加结果
-    logic [15:0] sum_u [0:OC2_LANES-1][0:MAX_ACT_SLICES-1];
+    localparam int N_TAPS        = KH * KW;
+    localparam int TAP_LVLS      = $clog2(N_TAPS);
+    localparam int PAIRS_PER_TAP = IC2_LANES / 2;
+    localparam int PAIR_LVLS     = $clog2(PAIRS_PER_TAP);
+    localparam int TAP_SUM_W     = $clog2(N_TAPS * 18 + 1);
+    localparam int SLICE_W       = TAP_SUM_W + PAIR_LVLS;
     
-    // 有符号结果 (去除 offset 后): sum_s[oc_lane][act_slice]
-    logic signed [ACC_W-1:0] sum_s [0:OC2_LANES-1][0:MAX_ACT_SLICES-1];
+    //=========================================================================
+    // 段 A: 每个 (oc_lane, pair) 对 KH*KW 个 tap 求和
+    // pair q 覆盖 ic lane 2q, 2q+1，同一 pair 的所有 tap 属于同一 act slice
+    //=========================================================================
+    logic [TAP_SUM_W-1:0] tap_sum [0:OC2_LANES-1][0:PAIRS_PER_TAP-1];
     
-    always_comb begin
-        // 初始化 - 所有元素清零
-        for (int oc_idx = 0; oc_idx < OC2_LANES; oc_idx++) begin
-            for (int s = 0; s < MAX_ACT_SLICES; s++) begin
-                sum_u[oc_idx][s] = '0;
-                sum_s[oc_idx][s] = '0;
+    generate
+        genvar ta_oc, ta_q;
+        for (ta_oc = 0; ta_oc < OC2_LANES; ta_oc++) begin : gen_tap_sum
+            for (ta_q = 0; ta_q < PAIRS_PER_TAP; ta_q++) begin : gen_pair
+                always_comb begin
+                    logic [TAP_SUM_W-1:0] node [0:(1 << TAP_LVLS)-1];
+                    for (int j = 0; j < (1 << TAP_LVLS); j++)
+                        node[j] = (j < N_TAPS) ? TAP_SUM_W'(lut_out[ta_oc][j / KW][j % KW][ta_q]) : '0;
+                    for (int l = 0; l < TAP_LVLS; l++)
+                        for (int j = 0; j < ((1 << TAP_LVLS) >> (l + 1)); j++)
+                            node[j] = node[2*j] + node[2*j+1];
+                    tap_sum[ta_oc][ta_q] = node[0];
+                end
             end
         end
-        
-        // 对每个 oc_lane
-        for (int oc_idx = 0; oc_idx < OC2_LANES; oc_idx++) begin
-            // 局部变量声明并初始化
-            logic [15:0] temp_sum;
-            int pair_start;
-            temp_sum = '0;
-            pair_start = 0;
-            
-            // 情况1: act_bits == 2 (单个 slice)
-            if (act_slices == 1) begin
-                // 累加所有 pairs
-                for (int kh_idx = 0; kh_idx < KH; kh_idx++) begin
-                    for (int kw_idx = 0; kw_idx < KW; kw_idx++) begin
-                        for (int p = 0; p < ic_lanes_per_slice/2; p++) begin
-                            temp_sum = temp_sum + lut_out[oc_idx][kh_idx][kw_idx][p];
-                        end
-                    end
+    endgenerate
+    
+    logic                 a_valid, a_ready;
+    logic [TAG_W-1:0]     a_tag;
+    logic [TAP_SUM_W-1:0] a_tap_sum [0:OC2_LANES-1][0:PAIRS_PER_TAP-1];
+    
+    generate
+        if (REG_A) begin : gen_reg_a
+            logic a_valid_r;
+            always_ff @(posedge clk or negedge rst_n) begin
+                if (!rst_n)
+                    a_valid_r <= 1'b0;
+                else if (in_ready)
+                    a_valid_r <= in_valid;
+            end
+            always_ff @(posedge clk) begin
+                if (in_ready) begin
+                    a_tag <= in_tag;
+                    a_tap_sum <= tap_sum;
                 end
-                sum_u[oc_idx][0] = temp_sum;
-                // 去除 offset: sum_s = sum_u - (N_PAIRS * 9)
-                sum_s[oc_idx][0] = signed'(temp_sum) - signed'(n_pairs * 9);
             end
-            // 情况2: act_bits > 2 (多个 slices)
-            else begin
-                for (int s = 0; s < act_slices; s++) begin
-                    temp_sum = '0;
-                    pair_start = 0;
-                    
-                    // 该 slice 对应的 ic lane 范围: [s*ic_lanes_per_slice, (s+1)*ic_lanes_per_slice-1]
-                    // 转换为 pair 索引: pair = lane/2
-                    pair_start = (s * ic_lanes_per_slice) >> 1;
-                    
-                    for (int kh_idx = 0; kh_idx < KH; kh_idx++) begin
-                        for (int kw_idx = 0; kw_idx < KW; kw_idx++) begin
-                            for (int p = 0; p < ic_lanes_per_slice/2; p++) begin
-                                temp_sum = temp_sum + lut_out[oc_idx][kh_idx][kw_idx][pair_start + p];
-                            end
-                        end
-                    end
-                    sum_u[oc_idx][s] = temp_sum;
-                    sum_s[oc_idx][s] = signed'(temp_sum) - signed'(n_pairs * 9);
+            assign a_valid = a_valid_r;
+            assign in_ready = a_ready || !a_valid_r;
+        end else begin : gen_wire_a
+            assign a_valid = in_valid;
+            assign a_tag = in_tag;
+            assign a_tap_sum = tap_sum;
+            assign in_ready = a_ready;
+        end
+    endgenerate
+    
+    //=========================================================================
+    // 段 B: pair 的分段求和
+    // act slice 内的 pair 连续，二叉树第 l 级的节点 j 正好是 2^l 个 pair 之和，
+    // 每 slice 有 PAIRS_PER_TAP / act_slices 个 pair，取对应级即为各 slice 的和
+    //=========================================================================
+    logic [2:0] slice_lvl;
+    always_comb begin
+        case (act_slices)
+            4'd2:    slice_lvl = 3'(PAIR_LVLS - 1);
+            4'd4:    slice_lvl = 3'(PAIR_LVLS - 2);
+            4'd8:    slice_lvl = 3'(PAIR_LVLS - 3);
+            default: slice_lvl = 3'(PAIR_LVLS);
+        endcase
+    end
+    
+    logic [SLICE_W-1:0] slice_sum [0:OC2_LANES-1][0:MAX_ACT_SLICES-1];
+    
+    generate
+        genvar sb_oc;
+        for (sb_oc = 0; sb_oc < OC2_LANES; sb_oc++) begin : gen_slice_sum
+            always_comb begin
+                logic [SLICE_W-1:0] node [0:PAIR_LVLS][0:PAIRS_PER_TAP-1];
+                for (int l = 0; l <= PAIR_LVLS; l++)
+                    for (int j = 0; j < PAIRS_PER_TAP; j++)
+                        node[l][j] = '0;
+                for (int j = 0; j < PAIRS_PER_TAP; j++)
+                    node[0][j] = SLICE_W'(a_tap_sum[sb_oc][j]);
+                for (int l = 1; l <= PAIR_LVLS; l++)
+                    for (int j = 0; j < (PAIRS_PER_TAP >> l); j++)
+                        node[l][j] = node[l-1][2*j] + node[l-1][2*j+1];
+                for (int s = 0; s < MAX_ACT_SLICES; s++)
+                    slice_sum[sb_oc][s] = (s < act_slices) ? node[slice_lvl][s] : '0;
+            end
+        end
+    endgenerate
+    
+    logic               b_valid, b_ready;
+    logic [TAG_W-1:0]   b_tag;
+    logic [SLICE_W-1:0] b_slice_sum [0:OC2_LANES-1][0:MAX_ACT_SLICES-1];
+    
+    generate
+        if (REG_B) begin : gen_reg_b
+            logic b_valid_r;
+            always_ff @(posedge clk or negedge rst_n) begin
+                if (!rst_n)
+                    b_valid_r <= 1'b0;
+                else if (a_ready)
+                    b_valid_r <= a_valid;
+            end
+            always_ff @(posedge clk) begin
+                if (a_ready) begin
+                    b_tag <= a_tag;
+                    b_slice_sum <= slice_sum;
                 end
             end
+            assign b_valid = b_valid_r;
+            assign a_ready = b_ready || !b_valid_r;
+        end else begin : gen_wire_b
+            assign b_valid = a_valid;
+            assign b_tag = a_tag;
+            assign b_slice_sum = slice_sum;
+            assign a_ready = b_ready;
         end
+    endgenerate
+    
+    //=========================================================================
+    // offset 常数折叠
+    // 每个 LUT 输出为 (pair_sum + 18) >> 1 = pair_sum / 2 + 9，一个 slice 的
+    // 无符号和比有符号和多 n_pairs * 9 (n_pairs = KH*KW*ic_lanes_per_slice/2)。
+    // 两次 slice 合并都是线性的，各 slice 的 offset 合起来为
+    //   lut_offset = n_pairs * 9 * sum_{s<act_slices} 4^s * sum_{g<wgt_slices} 4^g
+    // 对每种 (act_bits, wgt_bits) 都是常数，按 ACC_W 位取模，与补码累加一致。
+    // lane 内不再逐 slice 相减，由调用方在累加器初值中扣除一次。
+    //=========================================================================
+    function automatic logic [ACC_W-1:0] calc_lut_offset(input int a_slices, input int w_slices);
+        logic [63:0] geo_a, geo_w;
+        geo_a = '0;
+        geo_w = '0;
+        for (int s = 0; s < a_slices; s++)
+            geo_a = geo_a + (64'd1 << (2*s));
+        for (int g = 0; g < w_slices; g++)
+            geo_w = geo_w + (64'd1 << (2*g));
+        return ACC_W'(64'(KH * KW * (IC2_LANES / a_slices) / 2 * 9) * geo_a * geo_w);
+    endfunction
+    
+    always_comb begin
+        case ({act_slices, wgt_slices})
+            {4'd1, 4'd1}: lut_offset = calc_lut_offset(1, 1);
+            {4'd1, 4'd2}: lut_offset = calc_lut_offset(1, 2);
+            {4'd1, 4'd4}: lut_offset = calc_lut_offset(1, 4);
+            {4'd1, 4'd8}: lut_offset = calc_lut_offset(1, 8);
+            {4'd2, 4'd1}: lut_offset = calc_lut_offset(2, 1);
+            {4'd2, 4'd2}: lut_offset = calc_lut_offset(2, 2);
+            {4'd2, 4'd4}: lut_offset = calc_lut_offset(2, 4);
+            {4'd2, 4'd8}: lut_offset = calc_lut_offset(2, 8);
+            {4'd4, 4'd1}: lut_offset = calc_lut_offset(4, 1);
+            {4'd4, 4'd2}: lut_offset = calc_lut_offset(4, 2);
+            {4'd4, 4'd4}: lut_offset = calc_lut_offset(4, 4);
+            {4'd4, 4'd8}: lut_offset = calc_lut_offset(4, 8);
+            {4'd8, 4'd1}: lut_offset = calc_lut_offset(8, 1);
+            {4'd8, 4'd2}: lut_offset = calc_lut_offset(8, 2);
+            {4'd8, 4'd4}: lut_offset = calc_lut_offset(8, 4);
+            {4'd8, 4'd8}: lut_offset = calc_lut_offset(8, 8);
+            default:      lut_offset = '0;
+        endcase
     end
-
+    
     //=========================================================================
-    // slice 合并逻辑
+    // 段 C: 合并 act slice (无符号和，移位量为常数 2s)
+    // act_merged = sum(sum_u <<< 2s)
+    // 每个 oc_lane 在各自的 generate 块里，Verilator --threads 可按 lane 划分线程
     //=========================================================================
+    localparam int ACT_LVLS = $clog2(MAX_ACT_SLICES);
     
-    // 第一步: 合并 act_slices (当 act_bits > 2 时)
-    // result_after_act_merge[oc_lane]
-    logic signed [ACC_W-1:0] result_after_act_merge [0:OC2_LANES-1];
+    logic signed [ACC_W-1:0] act_merged [0:OC2_LANES-1];
     
-    always_comb begin
-        for (int oc_idx = 0; oc_idx < OC2_LANES; oc_idx++) begin
-            logic signed [ACC_W-1:0] temp;
-            temp = '0;
-            
-            if (act_slices == 1) begin
-                temp = sum_s[oc_idx][0];
-            end else begin
-                for (int s = 0; s < act_slices; s++) begin
-                    // sum_s[s] <<< (2*s)
-                    temp = temp + (sum_s[oc_idx][s] <<< (2*s));
+    generate
+        genvar sc_oc;
+        for (sc_oc = 0; sc_oc < OC2_LANES; sc_oc++) begin : gen_act_merge
+            always_comb begin
+                logic signed [ACC_W-1:0] node [0:MAX_ACT_SLICES-1];
+                for (int s = 0; s < MAX_ACT_SLICES; s++) begin
+                    if (s < act_slices)
+                        node[s] = signed'(ACC_W'(b_slice_sum[sc_oc][s])) <<< (2*s);
+                    else
+                        node[s] = '0;
                 end
+                for (int l = 0; l < ACT_LVLS; l++)
+                    for (int j = 0; j < (MAX_ACT_SLICES >> (l + 1)); j++)
+                        node[j] = node[2*j] + node[2*j+1];
+                act_merged[sc_oc] = node[0];
             end
-            result_after_act_merge[oc_idx] = temp;
         end
-    end
+    endgenerate
+    
+    logic                    c_valid, c_ready;
+    logic [TAG_W-1:0]        c_tag;
+    logic signed [ACC_W-1:0] c_act_merged [0:OC2_LANES-1];
+    
+    generate
+        if (REG_C) begin : gen_reg_c
+            logic c_valid_r;
+            always_ff @(posedge clk or negedge rst_n) begin
+                if (!rst_n)
+                    c_valid_r <= 1'b0;
+                else if (b_ready)
+                    c_valid_r <= b_valid;
+            end
+            always_ff @(posedge clk) begin
+                if (b_ready) begin
+                    c_tag <= b_tag;
+                    c_act_merged <= act_merged;
+                end
+            end
+            assign c_valid = c_valid_r;
+            assign b_ready = c_ready || !c_valid_r;
+        end else begin : gen_wire_c
+            assign c_valid = b_valid;
+            assign c_tag = b_tag;
+            assign c_act_merged = act_merged;
+            assign b_ready = c_ready;
+        end
+    endgenerate
+    
+    //=========================================================================
+    // 段 D: 合并 wgt_slices (当 wgt_bits > 2 时)
+    // oc_lane = g * oc_lanes_per_slice + p，结果放在 lane p
+    //=========================================================================
+    localparam int WGT_LVLS = $clog2(MAX_WGT_SLICES);
     
-    // 第二步: 合并 wgt_slices (当 wgt_bits > 2 时)
-    // 将 oc_lane 映射到物理通道和 slice
-    // oc_lane = g * oc_lanes_per_slice + p
     logic signed [ACC_W-1:0] final_result [0:OC2_LANES-1];
     
     always_comb begin
-        // 声明并初始化局部变量
-        logic signed [ACC_W-1:0] temp;
-        int oc_lane;
-        temp = '0;
-        oc_lane = 0;
-        
-        for (int i = 0; i < OC2_LANES; i++) begin
-            final_result[i] = '0;
-        end
+        logic signed [ACC_W-1:0] node [0:MAX_WGT_SLICES-1];
         
-        if (wgt_slices == 1) begin
-            // wgt_bits == 2, 直接输出
-            for (int oc_idx = 0; oc_idx < OC2_LANES; oc_idx++) begin
-                final_result[oc_idx] = result_after_act_merge[oc_idx];
-            end
-        end else begin
-            // wgt_bits > 2, 需要合并 slices
-            // 对每个物理输出通道 p
-            for (int p = 0; p < oc_lanes_per_slice; p++) begin
-                temp = '0;
-                
-                for (int g = 0; g < wgt_slices; g++) begin
-                    oc_lane = g * oc_lanes_per_slice + p;
-                    temp = temp + (result_after_act_merge[oc_lane] <<< (2*g));
+        for (int p = 0; p < OC2_LANES; p++) begin
+            if (wgt_slices == 1) begin
+                // wgt_bits == 2, 直接输出
+                final_result[p] = c_act_merged[p];
+            end else if (p < oc_lanes_per_slice) begin
+                for (int g = 0; g < MAX_WGT_SLICES; g++) begin
+                    if (g < wgt_slices)
+                        node[g] = c_act_merged[g * oc_lanes_per_slice + p] <<< (2*g);
+                    else
+                        node[g] = '0;
                 end
-                
-                // 输出到第一个 slice 对应的 oc_lane
-                final_result[p] = temp;
+                for (int l = 0; l < WGT_LVLS; l++)
+                    for (int j = 0; j < (MAX_WGT_SLICES >> (l + 1)); j++)
+                        node[j] = node[2*j] + node[2*j+1];
+                final_result[p] = node[0];
+            end else begin
+                final_result[p] = '0;
             end
         end
     end
 
     //=========================================================================
-    // 输出寄存器 (打一拍提高时序)
+    // 输出寄存器
     //=========================================================================
     logic signed [ACC_W-1:0] partial_reg [0:OC2_LANES-1];
+    logic [TAG_W-1:0]        tag_reg;
     logic                    out_valid_reg;
     
     always_ff @(posedge clk or negedge rst_n) begin
         if (!rst_n) begin
             out_valid_reg <= 1'b0;
+            tag_reg <= '0;
             for (int i = 0; i < OC2_LANES; i++) begin
                 partial_reg[i] <= '0;
             end
         end else begin
-            if (out_ready || !out_valid_reg) begin
-                out_valid_reg <= in_valid;
+            if (c_ready) begin
+                out_valid_reg <= c_valid;
+                tag_reg <= c_tag;
                 for (int i = 0; i < OC2_LANES; i++) begin
                     partial_reg[i] <= final_result[i];
                 end
@@ -265,7 +415,8 @@ module conv_core_lowbit #(
     end
     
     assign out_valid = out_valid_reg;
-    assign in_ready = out_ready || !out_valid_reg;
+    assign out_tag = tag_reg;
+    assign c_ready = out_ready || !out_valid_reg;
     
     generate
         genvar out_idx;
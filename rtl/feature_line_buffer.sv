@@ -5,7 +5,22 @@
 // - Variable input dimensions (W, H, IC)
 // - Variable activation bitwidth (2/4/8/16)
 // - Stride 1 or 2
+// - Optional same padding (pad=1): border taps are synthesized during
+//   window generation, either masked to zero or set to a configured code
+// - Column tiles: only input columns [tile_x0, tile_x0 + tile_W) of each
+//   row are streamed and stored, so MAX_W bounds the tile rather than the
+//   layer width. The windows inside the tile are generated; win_x is the
+//   output column in the whole layer.
 // - 2-bit slice lane mapping for high-bitwidth activations
+// - Column reuse: consecutive windows of an ic group in a row share 2
+//   (stride 1) or 1 (stride 2) columns, kept per ic group, so only the new
+//   columns are read from the row buffers, one column per cycle through a
+//   single read path; columns ahead of the last are read into pre_col while
+//   the previous window is still held. Tap addresses are stepped, not
+//   multiplied.
+// - Wide ingest: act_in beats go through an elastic FIFO and a whole beat
+//   (BUS_W/act_bits elements, split at row ends) is written per cycle into
+//   row memory banked by element index
 // - Backpressure handling
 //============================================================================
 
@@ -14,7 +29,8 @@ module feature_line_buffer #(
     parameter int MAX_H        = 256,
     parameter int MAX_IC       = 256,
     parameter int BUS_W        = 128,
-    parameter int IC2_LANES    = 16
+    parameter int IC2_LANES    = 16,
+    parameter int ACT_FIFO_DEPTH = 4    // act_in beats buffered, power of 2
 )(
     // Clock and reset
     input  logic        clk,
@@ -26,6 +42,11 @@ module feature_line_buffer #(
     input  logic [15:0] cfg_IC,
     input  logic [4:0]  cfg_act_bits,   // 2, 4, 8, 16
     input  logic        cfg_stride,     // 0=1, 1=2
+    input  logic        cfg_pad,        // 0=valid, 1=same (one-pixel border)
+    input  logic        cfg_pad_use_code, // Border taps: 0=zero, 1=cfg_pad_code
+    input  logic [15:0] cfg_pad_code,   // Activation code of border taps
+    input  logic [15:0] cfg_tile_x0,    // First input column streamed
+    input  logic [15:0] cfg_tile_W,     // Input columns streamed, 0 = whole rows
     input  logic        cfg_valid,
     output logic        cfg_ready,
 
@@ -42,6 +63,7 @@ module feature_line_buffer #(
     output logic [15:0] win_x,
     output logic [7:0]  win_ic_grp,
     output logic [1:0]  win_act2 [0:2][0:2][0:IC2_LANES-1],
+    output logic        win_mask [0:2][0:2],    // 0 = tap contributes zero
 
     // Status outputs
     output logic        linebuf_ready,
@@ -56,6 +78,13 @@ module feature_line_buffer #(
     localparam int MAX_ACT_BITS  = 16;
     localparam int ROW_BITS      = MAX_ACT_BITS;
     localparam int ELEM_CNT_W    = $clog2(MAX_ROW_ELEMS + 1);
+    localparam int MAX_IC_GRP    = MAX_IC * 8 / IC2_LANES;  // 16-bit act: 2 ch/group
+    localparam int HIST_IDX_W    = $clog2(MAX_IC_GRP);
+    localparam int WR_BANKS      = BUS_W / 2;           // Elements per beat at 2 bits
+    localparam int BANK_W        = $clog2(WR_BANKS);
+    localparam int BANK_DEPTH    = (MAX_ROW_ELEMS + WR_BANKS - 1) / WR_BANKS;
+    localparam int FIFO_PTR_W    = $clog2(ACT_FIFO_DEPTH);
+    localparam int IMG_ELEM_W    = ELEM_CNT_W + 16;
     
     //========================================================================
     // FSM States
@@ -78,12 +107,19 @@ module feature_line_buffer #(
     logic [15:0] r_W, r_H, r_IC;
     logic [4:0]  r_act_bits;
     logic        r_stride;
-    logic [15:0] r_OH, r_OW;
+    logic        r_pad;
+    logic        r_pad_use_code;
+    logic [15:0] r_pad_code;
+    logic [15:0] r_OH, r_OW;            // r_OW: output columns of the tile
+    logic [15:0] r_ox0;                 // Layer output column of out_x = 0
+    logic [ELEM_CNT_W-1:0] r_row_addr0; // (in_x_base - tile_x0) * IC at out_x = 0
     
     logic [2:0]  r_act_slices;
     logic [4:0]  r_IC_CH_PER_CYCLE;
     logic [7:0]  r_num_ic_grp;
     logic [ELEM_CNT_W-1:0] r_elems_per_row;
+    logic [BANK_W:0] r_beat_elems;      // BUS_W / act_bits
+    logic [2:0]  r_bits_log2;           // log2(act_bits)
     
     // Configuration valid flag
     logic cfg_loaded;
@@ -102,13 +138,39 @@ module feature_line_buffer #(
         endcase
     endfunction
     
-    function automatic logic [15:0] calc_out_dim(input logic [15:0] in_dim, input logic stride);
-        if (in_dim < 16'd3)
+    function automatic logic [15:0] calc_out_dim(input logic [15:0] in_dim, input logic stride,
+                                                 input logic pad);
+        logic [16:0] eff_dim;
+        eff_dim = {1'b0, in_dim} + (pad ? 17'd2 : 17'd0);
+        if (eff_dim < 17'd3)
             return 16'd0;
         else if (stride)
-            return ((in_dim - 16'd3) >> 1) + 16'd1;
+            return 16'(((eff_dim - 17'd3) >> 1) + 17'd1);
         else
-            return (in_dim - 16'd3) + 16'd1;
+            return 16'((eff_dim - 17'd3) + 17'd1);
+    endfunction
+    
+    // Output columns of a column tile, in padded coordinates (input column
+    // x at x + pad). A tile at column 0 / ending at W includes the left /
+    // right border; the windows that fit in the tile are produced.
+    function automatic logic [15:0] calc_tile_ox0(input logic [15:0] x0, input logic stride,
+                                                  input logic pad);
+        logic [16:0] xs;
+        xs = (x0 == 16'd0) ? 17'd0 : {1'b0, x0} + {16'd0, pad};
+        return 16'(stride ? ((xs + 17'd1) >> 1) : xs);
+    endfunction
+    
+    function automatic logic [15:0] calc_tile_ow(input logic [15:0] W, input logic [15:0] x0,
+                                                 input logic [15:0] cols, input logic stride,
+                                                 input logic pad);
+        logic [17:0] xe, lo, hi;
+        xe = ({2'b0, x0} + {2'b0, cols} >= {2'b0, W}) ? {2'b0, W} + (pad ? 18'd2 : 18'd0) :
+                                                        {2'b0, x0} + {2'b0, cols} + {17'd0, pad};
+        if (xe < 18'd3)
+            return 16'd0;
+        lo = {2'b0, calc_tile_ox0(x0, stride, pad)};
+        hi = stride ? ((xe - 18'd3) >> 1) : (xe - 18'd3);
+        return (hi >= lo) ? 16'(hi - lo + 18'd1) : 16'd0;
     endfunction
 
     //========================================================================
@@ -122,12 +184,19 @@ module feature_line_buffer #(
             r_IC <= 16'd0;
             r_act_bits <= 5'd0;
             r_stride <= 1'b0;
+            r_pad <= 1'b0;
+            r_pad_use_code <= 1'b0;
+            r_pad_code <= 16'd0;
             r_OH <= 16'd0;
             r_OW <= 16'd0;
+            r_ox0 <= 16'd0;
+            r_row_addr0 <= '0;
             r_act_slices <= 3'd0;
             r_IC_CH_PER_CYCLE <= 5'd0;
             r_num_ic_grp <= 8'd0;
             r_elems_per_row <= '0;
+            r_beat_elems <= '0;
+            r_bits_log2 <= 3'd0;
             cfg_loaded <= 1'b0;
         end else if (cfg_valid && cfg_ready) begin
             r_W <= cfg_W;
@@ -135,14 +204,41 @@ module feature_line_buffer #(
             r_IC <= cfg_IC;
             r_act_bits <= cfg_act_bits;
             r_stride <= cfg_stride;
+            r_pad <= cfg_pad;
+            r_pad_use_code <= cfg_pad_use_code;
+            r_pad_code <= cfg_pad_code;
             
             r_act_slices <= calc_slices(cfg_act_bits);
             r_IC_CH_PER_CYCLE <= IC2_LANES[4:0] / calc_slices(cfg_act_bits);
-            r_num_ic_grp <= cfg_IC[7:0] / (IC2_LANES[7:0] / {5'd0, calc_slices(cfg_act_bits)});
-            r_elems_per_row <= cfg_W * cfg_IC;
+            r_num_ic_grp <= 8'(cfg_IC / 16'(IC2_LANES / calc_slices(cfg_act_bits)));
+            case (cfg_act_bits)
+                5'd4:    begin r_beat_elems <= (BANK_W+1)'(BUS_W / 4);  r_bits_log2 <= 3'd2; end
+                5'd8:    begin r_beat_elems <= (BANK_W+1)'(BUS_W / 8);  r_bits_log2 <= 3'd3; end
+                5'd16:   begin r_beat_elems <= (BANK_W+1)'(BUS_W / 16); r_bits_log2 <= 3'd4; end
+                default: begin r_beat_elems <= (BANK_W+1)'(BUS_W / 2);  r_bits_log2 <= 3'd1; end
+            endcase
+            
+            // cfg_tile_W = 0: the whole row is one tile
+            if (cfg_tile_W == 16'd0) begin
+                r_ox0 <= 16'd0;
+                r_row_addr0 <= '0;
+                r_elems_per_row <= ELEM_CNT_W'(cfg_W * cfg_IC);
+                r_OW <= calc_out_dim(cfg_W, cfg_stride, cfg_pad);
+            end else begin
+                logic [15:0] ox0;
+                logic [1:0]  x_off;
+                // The first window of the tile starts 0..2 columns right of
+                // tile_x0 in padded coordinates
+                ox0 = calc_tile_ox0(cfg_tile_x0, cfg_stride, cfg_pad);
+                x_off = 2'((cfg_stride ? (ox0 << 1) : ox0) - cfg_tile_x0);
+                r_ox0 <= ox0;
+                r_row_addr0 <= x_off[1] ? ELEM_CNT_W'({cfg_IC, 1'b0}) :
+                               x_off[0] ? ELEM_CNT_W'(cfg_IC) : '0;
+                r_elems_per_row <= ELEM_CNT_W'(cfg_tile_W * cfg_IC);
+                r_OW <= calc_tile_ow(cfg_W, cfg_tile_x0, cfg_tile_W, cfg_stride, cfg_pad);
+            end
             
-            r_OH <= calc_out_dim(cfg_H, cfg_stride);
-            r_OW <= calc_out_dim(cfg_W, cfg_stride);
+            r_OH <= calc_out_dim(cfg_H, cfg_stride, cfg_pad);
             cfg_loaded <= 1'b1;
         end else if (state == ST_DONE) begin
             cfg_loaded <= 1'b0;
@@ -153,134 +249,199 @@ module feature_line_buffer #(
 
     //========================================================================
     // Line Buffer Storage (3 rows)
+    // Input row y is held in row_mem[y % 3], element e = (x - tile_x0) * IC + ic
+    // in bank e % WR_BANKS at e / WR_BANKS. The elements of one beat are
+    // consecutive, so a beat writes each bank at most once.
     //========================================================================
     
-    logic [ROW_BITS-1:0] row_mem [0:2][0:MAX_ROW_ELEMS-1];
+    logic [ROW_BITS-1:0] row_mem [0:2][0:WR_BANKS-1][0:BANK_DEPTH-1];
     
     // Write control
     logic [1:0]  wr_row_idx;
     logic [ELEM_CNT_W-1:0] wr_elem_idx;
-    logic [15:0] wr_y_pos;
-    
-    // Row status - tracks which rows have been filled
-    logic [2:0] row_filled;
+    logic [15:0] wr_y_pos;              // Input rows completely written
     
     //========================================================================
-    // Input Buffer and Element Extraction
+    // Window Position
+    // out_y/out_x/out_ic_grp point at the next window to be read; out_y
+    // reaches r_OH once the last window has been read.
     //========================================================================
     
-    // Accumulate input bits and extract elements
-    localparam int INBUF_BITS = BUS_W * 2;  // Buffer up to 2 beats
-    localparam int INBUF_CNT_W = $clog2(INBUF_BITS + 1);
+    logic [15:0] out_y, out_x;
+    logic [7:0]  out_ic_grp;
+    logic [1:0]  rd_base_row;           // Slot of input row in_y_base - pad
+    logic        windows_done;
     
-    logic [INBUF_BITS-1:0] inbuf;
-    logic [INBUF_CNT_W-1:0] inbuf_valid;
+    // Calculate input base coordinates (before the pad offset); x is the
+    // column in the whole layer
+    logic [15:0] in_y_base, in_x_base;
+    logic [15:0] layer_ox;
     
-    logic [4:0] bits_per_elem;
-    assign bits_per_elem = r_act_bits;
+    always_comb begin
+        layer_ox = r_ox0 + out_x;
+        in_y_base = r_stride ? (out_y << 1) : out_y;
+        in_x_base = r_stride ? (layer_ox << 1) : layer_ox;
+    end
     
-    wire can_extract = (inbuf_valid >= { {(INBUF_CNT_W-5){1'b0}}, bits_per_elem }) && 
-                       cfg_loaded && (bits_per_elem > 0);
-    wire can_accept = (inbuf_valid <= (INBUF_BITS[INBUF_CNT_W-1:0] - BUS_W[INBUF_CNT_W-1:0]));
+    assign windows_done = (out_y >= r_OH) || (r_OW == 16'd0);
     
-    // Extract element from LSB of buffer
-    logic [MAX_ACT_BITS-1:0] extract_elem;
-    assign extract_elem = inbuf[MAX_ACT_BITS-1:0] & 
-                          ({MAX_ACT_BITS{1'b1}} >> (MAX_ACT_BITS - bits_per_elem));
-
     //========================================================================
-    // Input Stream Handling
+    // Activation Input FIFO
+    // Beats are taken at bus rate while the FIFO has room, independent of
+    // the row writes; only the beats of this image are accepted, so the
+    // zero fill of its last beat is the only thing dropped.
     //========================================================================
     
-    assign act_in_ready = ((state == ST_FILL_ROWS) || (state == ST_PROCESS_WIN)) && 
-                          can_accept && (wr_y_pos < r_H) && cfg_loaded;
+    logic [BUS_W-1:0]      fifo_mem [0:ACT_FIFO_DEPTH-1];
+    logic [FIFO_PTR_W-1:0] fifo_wr_ptr, fifo_rd_ptr;
+    logic [FIFO_PTR_W:0]   fifo_count;
+    logic                  fifo_push, fifo_pop;
+    logic [IMG_ELEM_W-1:0] in_elems_left;       // Elements not yet accepted
+    
+    logic writing;
+    assign writing = (state == ST_FILL_ROWS) || (state == ST_PROCESS_WIN) || (state == ST_DRAIN);
     
-    // Buffer update logic
-    logic do_extract, do_shift_in;
-    assign do_extract = can_extract && (wr_elem_idx < r_elems_per_row) && (wr_y_pos < r_H);
-    assign do_shift_in = act_in_valid && act_in_ready;
+    assign act_in_ready = writing && cfg_loaded && (in_elems_left != '0) &&
+                          (fifo_count != (FIFO_PTR_W+1)'(ACT_FIFO_DEPTH));
+    assign fifo_push = act_in_valid && act_in_ready;
+    
+    always_ff @(posedge clk) begin
+        if (fifo_push)
+            fifo_mem[fifo_wr_ptr] <= act_in_data;
+    end
     
     always_ff @(posedge clk or negedge rst_n) begin
         if (!rst_n) begin
-            inbuf <= '0;
-            inbuf_valid <= '0;
+            fifo_wr_ptr <= '0;
+            fifo_rd_ptr <= '0;
+            fifo_count <= '0;
+            in_elems_left <= '0;
+        end else if (cfg_valid && cfg_ready) begin
+            fifo_wr_ptr <= '0;
+            fifo_rd_ptr <= '0;
+            fifo_count <= '0;
+            in_elems_left <= IMG_ELEM_W'(cfg_H) * IMG_ELEM_W'(cfg_IC) *
+                             IMG_ELEM_W'((cfg_tile_W == 16'd0) ? cfg_W : cfg_tile_W);
         end else begin
-            case ({do_shift_in, do_extract})
-                2'b00: ; // No operation
-                
-                2'b01: begin // Extract only
-                    inbuf <= inbuf >> bits_per_elem;
-                    inbuf_valid <= inbuf_valid - { {(INBUF_CNT_W-5){1'b0}}, bits_per_elem };
-                end
-                
-                2'b10: begin // Shift in only
-                    // Append new data at MSB side
-                    inbuf <= (act_in_data << inbuf_valid) | inbuf;
-                    inbuf_valid <= inbuf_valid + BUS_W[INBUF_CNT_W-1:0];
-                end
-                
-                2'b11: begin // Both extract and shift in
-                    // First extract (shift right), then append new data
-                    logic [INBUF_BITS-1:0] after_extract;
-                    after_extract = inbuf >> bits_per_elem;
-                    inbuf <= (act_in_data << (inbuf_valid - { {(INBUF_CNT_W-5){1'b0}}, bits_per_elem })) | 
-                             after_extract;
-                    inbuf_valid <= inbuf_valid - { {(INBUF_CNT_W-5){1'b0}}, bits_per_elem } + 
-                                   BUS_W[INBUF_CNT_W-1:0];
-                end
-            endcase
+            if (fifo_push) begin
+                fifo_wr_ptr <= fifo_wr_ptr + 1'b1;
+                in_elems_left <= (in_elems_left > IMG_ELEM_W'(r_beat_elems)) ?
+                                 in_elems_left - IMG_ELEM_W'(r_beat_elems) : '0;
+            end
+            if (fifo_pop)
+                fifo_rd_ptr <= fifo_rd_ptr + 1'b1;
+            fifo_count <= fifo_count + (FIFO_PTR_W+1)'(fifo_push) - (FIFO_PTR_W+1)'(fifo_pop);
         end
     end
 
     //========================================================================
     // Write Logic - Store elements into row buffers
+    // The head beat is written from element beat_pos on, up to the end of
+    // the beat or of the row, whichever comes first, in one cycle
     //========================================================================
     
     logic input_complete;
-    assign input_complete = (wr_y_pos >= r_H) || 
-                            (act_in_last && act_in_valid && act_in_ready);
+    assign input_complete = (wr_y_pos >= r_H);
+    
+    logic [BANK_W:0]   beat_pos;                // Head beat elements written
+    logic [BANK_W:0]   wr_n;                    // Elements written this cycle
+    logic              row_end, image_end;
+    logic [BUS_W-1:0]  head_shift;              // Head beat from element beat_pos
+    logic [ROW_BITS-1:0] chunk_elem [0:WR_BANKS-1];
+    
+    always_comb begin
+        logic [ELEM_CNT_W-1:0] row_left;
+        logic [BANK_W:0]       beat_left;
+        row_left  = r_elems_per_row - wr_elem_idx;
+        beat_left = r_beat_elems - beat_pos;
+        wr_n = (row_left < ELEM_CNT_W'(beat_left)) ? (BANK_W+1)'(row_left) : beat_left;
+        row_end = (ELEM_CNT_W'(wr_n) == row_left);
+        image_end = row_end && (wr_y_pos + 16'd1 >= r_H);
+        head_shift = fifo_mem[fifo_rd_ptr] >> (beat_pos << r_bits_log2);
+    end
+    
+    // Element i of the chunk, element i at [i*bits +: bits] as in the bus
+    genvar e_g;
+    generate
+        for (e_g = 0; e_g < WR_BANKS; e_g++) begin : gen_chunk
+            logic [ROW_BITS-1:0] e4, e8, e16;
+            if (e_g < BUS_W / 4) begin : g_e4
+                assign e4 = ROW_BITS'(head_shift[4*e_g +: 4]);
+            end else begin : g_n4
+                assign e4 = '0;
+            end
+            if (e_g < BUS_W / 8) begin : g_e8
+                assign e8 = ROW_BITS'(head_shift[8*e_g +: 8]);
+            end else begin : g_n8
+                assign e8 = '0;
+            end
+            if (e_g < BUS_W / 16) begin : g_e16
+                assign e16 = head_shift[16*e_g +: 16];
+            end else begin : g_n16
+                assign e16 = '0;
+            end
+            
+            always_comb begin
+                case (r_act_bits)
+                    5'd4:    chunk_elem[e_g] = e4;
+                    5'd8:    chunk_elem[e_g] = e8;
+                    5'd16:   chunk_elem[e_g] = e16;
+                    default: chunk_elem[e_g] = ROW_BITS'(head_shift[2*e_g +: 2]);
+                endcase
+            end
+        end
+    endgenerate
+    
+    // Row wr_y_pos goes to the slot of row wr_y_pos - 3, which is free once
+    // the next window starts below it (first row of the window at out_y is
+    // in_y_base - pad). After the last window the remaining rows are only
+    // consumed.
+    logic wr_row_free;
+    assign wr_row_free = windows_done ||
+                         ({1'b0, wr_y_pos} + {16'd0, r_pad} < {1'b0, in_y_base} + 17'd3);
+    
+    logic do_write;
+    assign do_write = writing && (fifo_count != '0) && wr_row_free && !input_complete;
+    // The rest of the image's last beat is zero fill
+    assign fifo_pop = do_write && ((beat_pos + wr_n == r_beat_elems) || image_end);
+    
+    integer b_i;
+    always_ff @(posedge clk) begin
+        if (do_write) begin
+            for (b_i = 0; b_i < WR_BANKS; b_i++) begin
+                logic [BANK_W-1:0]     i;       // Chunk element landing in bank b_i
+                logic [ELEM_CNT_W-1:0] addr;
+                i = BANK_W'(b_i) - wr_elem_idx[BANK_W-1:0];
+                addr = wr_elem_idx + ELEM_CNT_W'(i);
+                if ({1'b0, i} < wr_n)
+                    row_mem[wr_row_idx][b_i][addr >> BANK_W] <= chunk_elem[i];
+            end
+        end
+    end
     
     always_ff @(posedge clk or negedge rst_n) begin
         if (!rst_n) begin
             wr_row_idx <= 2'd0;
             wr_elem_idx <= '0;
             wr_y_pos <= 16'd0;
-            row_filled <= 3'b000;
+            beat_pos <= '0;
         end else begin
-            case (state)
-                ST_IDLE: begin
-                    wr_row_idx <= 2'd0;
+            if (state == ST_IDLE) begin
+                wr_row_idx <= 2'd0;
+                wr_elem_idx <= '0;
+                wr_y_pos <= 16'd0;
+                beat_pos <= '0;
+            end else if (do_write) begin
+                beat_pos <= fifo_pop ? '0 : beat_pos + wr_n;
+                if (row_end) begin
+                    // Row complete, move to next row (circular)
                     wr_elem_idx <= '0;
-                    wr_y_pos <= 16'd0;
-                    row_filled <= 3'b000;
-                end
-                
-                ST_FILL_ROWS, ST_PROCESS_WIN: begin
-                    if (do_extract) begin
-                        // Write element to current row
-                        row_mem[wr_row_idx][wr_elem_idx] <= extract_elem;
-                        
-                        // Update write pointers
-                        if (wr_elem_idx + 1 >= r_elems_per_row) begin
-                            // Row complete
-                            wr_elem_idx <= '0;
-                            row_filled[wr_row_idx] <= 1'b1;
-                            
-                            if (wr_y_pos + 1 < r_H) begin
-                                wr_y_pos <= wr_y_pos + 16'd1;
-                                // Move to next row (circular)
-                                wr_row_idx <= (wr_row_idx == 2'd2) ? 2'd0 : wr_row_idx + 2'd1;
-                            end else begin
-                                wr_y_pos <= wr_y_pos + 16'd1;
-                            end
-                        end else begin
-                            wr_elem_idx <= wr_elem_idx + 1'b1;
-                        end
-                    end
+                    wr_y_pos <= wr_y_pos + 16'd1;
+                    wr_row_idx <= (wr_row_idx == 2'd2) ? 2'd0 : wr_row_idx + 2'd1;
+                end else begin
+                    wr_elem_idx <= wr_elem_idx + ELEM_CNT_W'(wr_n);
                 end
-                
-                default: ; // Hold values
-            endcase
+            end
         end
     end
 
@@ -288,8 +449,18 @@ module feature_line_buffer #(
     // FSM State Machine
     //========================================================================
     
-    logic all_rows_ready;
-    assign all_rows_ready = (row_filled[0] & row_filled[1] & row_filled[2]);
+    // Last input row read by the window at out_y (the bottom border row of
+    // a padded layer is not stored)
+    logic [16:0] need_row;
+    logic        win_rows_ready;
+    
+    always_comb begin
+        need_row = {1'b0, in_y_base} + 17'd2 - {16'd0, r_pad};
+        if (need_row >= {1'b0, r_H})
+            need_row = {1'b0, r_H} - 17'd1;
+    end
+    
+    assign win_rows_ready = ({1'b0, wr_y_pos} > need_row);
     
     always_ff @(posedge clk or negedge rst_n) begin
         if (!rst_n)
@@ -308,21 +479,18 @@ module feature_line_buffer #(
             end
             
             ST_FILL_ROWS: begin
-                if (all_rows_ready)
+                if (win_rows_ready)
                     next_state = ST_PROCESS_WIN;
-                else if (input_complete && !all_rows_ready)
-                    next_state = ST_DONE;
             end
             
             ST_PROCESS_WIN: begin
-                if (input_complete && win_valid && win_ready && 
-                    (win_y >= r_OH - 1) && (win_x >= r_OW - 1) && (win_ic_grp >= r_num_ic_grp - 1))
+                if (windows_done)
                     next_state = ST_DRAIN;
             end
             
             ST_DRAIN: begin
-                if (win_valid && win_ready && 
-                    (win_y >= r_OH - 1) && (win_x >= r_OW - 1) && (win_ic_grp >= r_num_ic_grp - 1))
+                // Last window taken and the rest of the input consumed
+                if (input_complete && (!win_valid || win_ready))
                     next_state = ST_DONE;
             end
             
@@ -338,26 +506,32 @@ module feature_line_buffer #(
     // Window Generation - Output position tracking
     //========================================================================
     
-    logic [15:0] out_y, out_x;
-    logic [7:0]  out_ic_grp;
-    logic [1:0] rd_base_row;
-    
-    // Calculate input base coordinates
-    logic [15:0] in_y_base, in_x_base;
-    
-    always_comb begin
-        in_y_base = r_stride ? (out_y << 1) : out_y;
-        in_x_base = r_stride ? (out_x << 1) : out_x;
-    end
-    
-    // Window advancement
-    logic win_advancing;
-    logic ic_grp_done, x_done, y_done;
-    
-    assign win_advancing = win_valid && win_ready;
+    // Window read: the row buffers are read one column (3 rows x
+    // IC_CH_PER_CYCLE elements) per cycle. Columns of the window at
+    // (out_y, out_x, out_ic_grp) not covered by col_hist are read first into
+    // pre_col, independently of the output register; column 2 is read as
+    // the taps are loaded into the output register once their rows are
+    // stored and the register is free
+    logic win_load;
+    logic pre_rd;                       // Read column rd_col into pre_col
+    logic [1:0] pre_cnt;                // Columns already in pre_col
+    logic [1:0] rd_col;                 // Column read this cycle
+    logic win_valid_r;
+    logic ic_grp_done, x_done;
+    
+    // Running read addresses of the window at out_x: win_addr is
+    // (in_x_base - tile_x0) * IC, ic_base is out_ic_grp * IC_CH_PER_CYCLE
+    logic [ELEM_CNT_W-1:0] win_addr, ic_base;
+    logic [ELEM_CNT_W-1:0] x_step;
+    
+    assign x_step = r_stride ? ELEM_CNT_W'({r_IC, 1'b0}) : ELEM_CNT_W'(r_IC);
+    
+    assign pre_rd   = (state == ST_PROCESS_WIN) && !windows_done && win_rows_ready &&
+                      (rd_col != 2'd2);
+    assign win_load = (state == ST_PROCESS_WIN) && !windows_done && win_rows_ready &&
+                      (rd_col == 2'd2) && (!win_valid_r || win_ready);
     assign ic_grp_done = (out_ic_grp + 8'd1 >= r_num_ic_grp);
     assign x_done = (out_x + 16'd1 >= r_OW);
-    assign y_done = (out_y + 16'd1 >= r_OH);
     
     always_ff @(posedge clk or negedge rst_n) begin
         if (!rst_n) begin
@@ -365,49 +539,46 @@ module feature_line_buffer #(
             out_x <= 16'd0;
             out_ic_grp <= 8'd0;
             rd_base_row <= 2'd0;
+            win_addr <= '0;
+            ic_base <= '0;
         end else begin
             case (state)
-                ST_IDLE: begin
+                ST_IDLE, ST_FILL_ROWS: begin
                     out_y <= 16'd0;
                     out_x <= 16'd0;
                     out_ic_grp <= 8'd0;
-                    rd_base_row <= 2'd0;
-                end
-                
-                ST_FILL_ROWS: begin
-                    if (all_rows_ready) begin
-                        out_y <= 16'd0;
-                        out_x <= 16'd0;
-                        out_ic_grp <= 8'd0;
-                        rd_base_row <= 2'd0;
-                    end
+                    win_addr <= r_row_addr0;
+                    ic_base <= '0;
+                    // Top border row -1 of a padded layer maps to slot 2
+                    rd_base_row <= r_pad ? 2'd2 : 2'd0;
                 end
                 
-                ST_PROCESS_WIN, ST_DRAIN: begin
-                    if (win_advancing) begin
+                ST_PROCESS_WIN: begin
+                    if (win_load) begin
                         if (!ic_grp_done) begin
                             out_ic_grp <= out_ic_grp + 8'd1;
+                            ic_base <= ic_base + ELEM_CNT_W'(r_IC_CH_PER_CYCLE);
                         end else begin
                             out_ic_grp <= 8'd0;
+                            ic_base <= '0;
                             
                             if (!x_done) begin
                                 out_x <= out_x + 16'd1;
+                                win_addr <= win_addr + x_step;
                             end else begin
                                 out_x <= 16'd0;
-                                
-                                if (!y_done) begin
-                                    out_y <= out_y + 16'd1;
-                                    // Advance base row by stride (modulo 3)
-                                    case ({r_stride, rd_base_row})
-                                        3'b0_00: rd_base_row <= 2'd1;
-                                        3'b0_01: rd_base_row <= 2'd2;
-                                        3'b0_10: rd_base_row <= 2'd0;
-                                        3'b1_00: rd_base_row <= 2'd2;
-                                        3'b1_01: rd_base_row <= 2'd0;
-                                        3'b1_10: rd_base_row <= 2'd1;
-                                        default: rd_base_row <= 2'd0;
-                                    endcase
-                                end
+                                win_addr <= r_row_addr0;
+                                out_y <= out_y + 16'd1;
+                                // Advance base row by stride (modulo 3)
+                                case ({r_stride, rd_base_row})
+                                    3'b0_00: rd_base_row <= 2'd1;
+                                    3'b0_01: rd_base_row <= 2'd2;
+                                    3'b0_10: rd_base_row <= 2'd0;
+                                    3'b1_00: rd_base_row <= 2'd2;
+                                    3'b1_01: rd_base_row <= 2'd0;
+                                    3'b1_10: rd_base_row <= 2'd1;
+                                    default: rd_base_row <= 2'd0;
+                                endcase
                             end
                         end
                     end
@@ -433,115 +604,156 @@ module feature_line_buffer #(
         endcase
     end
     
-    // Raw window data - registered output
-    logic [ROW_BITS-1:0] raw_win [0:2][0:2][0:15];  // [kh][kw][ch]
-    
-    // Window position in input feature map
-    logic [15:0] win_y_pos [0:2];
-    logic [15:0] win_x_pos [0:2];
+    // Window register, already in 2-bit lanes, and the kw = 1 / 2 columns
+    // of the last window read per ic group (slot 0 / 1)
+    logic [1:0]  win_reg [0:2][0:2][0:IC2_LANES-1];   // [kh][kw][lane]
+    logic [1:0]  col_hist [0:MAX_IC_GRP-1][0:1][0:2][0:IC2_LANES-1];
+    logic        raw_mask [0:2][0:2];
+    logic [15:0] r_win_y, r_win_x;
+    logic [7:0]  r_win_ic_grp;
+    
+    // Tap position in the input feature map plus the pad offset, so the
+    // top / left border is at 0 and the image starts at r_pad
+    logic [16:0] tap_y [0:2];
+    logic [16:0] tap_x [0:2];
+    logic        tap_y_in [0:2];
+    logic        tap_x_in [0:2];
     
     genvar kh_g, kw_g;
     generate
         for (kh_g = 0; kh_g < 3; kh_g++) begin : gen_win_y
-            always_comb win_y_pos[kh_g] = in_y_base + kh_g[15:0];
+            always_comb begin
+                tap_y[kh_g] = {1'b0, in_y_base} + 17'(kh_g);
+                tap_y_in[kh_g] = (tap_y[kh_g] >= {16'd0, r_pad}) &&
+                                 (tap_y[kh_g] - {16'd0, r_pad} < {1'b0, r_H});
+            end
         end
         for (kw_g = 0; kw_g < 3; kw_g++) begin : gen_win_x
-            always_comb win_x_pos[kw_g] = in_x_base + kw_g[15:0];
+            always_comb begin
+                tap_x[kw_g] = {1'b0, in_x_base} + 17'(kw_g);
+                tap_x_in[kw_g] = (tap_x[kw_g] >= {16'd0, r_pad}) &&
+                                 (tap_x[kw_g] - {16'd0, r_pad} < {1'b0, r_W});
+            end
         end
     endgenerate
     
-    // Address calculation: addr = ((y * W) + x) * IC + ic
-    // Pre-calculate (y*W + x)*IC part for each window position
-    logic [ELEM_CNT_W-1:0] addr_base [0:2][0:2];
+    // Address of column kw of the window: (x - tile_x0) * IC with
+    // x = in_x_base + kw - pad. Taps outside the image wrap but are not read.
+    logic [ELEM_CNT_W-1:0] col_addr [0:2];
     
-    integer kh_i, kw_i;
     always_comb begin
-        logic [31:0] full_addr;
-        full_addr = '0;
-        for (kh_i = 0; kh_i < 3; kh_i++) begin
-            for (kw_i = 0; kw_i < 3; kw_i++) begin
-                full_addr = ((win_y_pos[kh_i] * r_W + win_x_pos[kw_i]) * r_IC);
-                addr_base[kh_i][kw_i] = full_addr[ELEM_CNT_W-1:0];
-            end
-        end
+        logic [ELEM_CNT_W-1:0] ic_e;
+        ic_e = ELEM_CNT_W'(r_IC);
+        col_addr[0] = r_pad ? win_addr - ic_e : win_addr;
+        col_addr[1] = r_pad ? win_addr : win_addr + ic_e;
+        col_addr[2] = r_pad ? win_addr + ic_e : win_addr + {ic_e[ELEM_CNT_W-2:0], 1'b0};
     end
     
-    // Sequential read from row memories
-    integer ch_i;
-    logic [ELEM_CNT_W-1:0] read_addr;
-    logic [15:0] abs_ic;
+    // Columns of the window taken from col_hist instead of the row buffers:
+    // column kw is column kw + stride of the previous window of this ic
+    // group, i.e. slot kw + r_stride. The first window of a row reads all.
+    logic [1:0]            reuse_cols;
+    logic [HIST_IDX_W-1:0] hist_idx;
     
-    always_ff @(posedge clk) begin
-        for (kh_i = 0; kh_i < 3; kh_i++) begin
-            for (kw_i = 0; kw_i < 3; kw_i++) begin
-                for (ch_i = 0; ch_i < 16; ch_i++) begin
-                    if (ch_i < r_IC_CH_PER_CYCLE) begin
-                        abs_ic = out_ic_grp * r_IC_CH_PER_CYCLE + ch_i[15:0];
-                        read_addr = addr_base[kh_i][kw_i] + abs_ic[ELEM_CNT_W-1:0];
-                        
-                        if (read_addr < r_elems_per_row)
-                            raw_win[kh_i][kw_i][ch_i] <= row_mem[rd_row_idx[kh_i]][read_addr];
-                        else
-                            raw_win[kh_i][kw_i][ch_i] <= '0;
-                    end else begin
-                        raw_win[kh_i][kw_i][ch_i] <= '0;
-                    end
-                end
-            end
-        end
+    assign reuse_cols = (out_x == 16'd0) ? 2'd0 : (r_stride ? 2'd1 : 2'd2);
+    assign hist_idx = HIST_IDX_W'(out_ic_grp);
+    assign rd_col = reuse_cols + pre_cnt;
+    
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n)
+            pre_cnt <= 2'd0;
+        else if (state != ST_PROCESS_WIN || win_load)
+            pre_cnt <= 2'd0;
+        else if (pre_rd)
+            pre_cnt <= pre_cnt + 2'd1;
     end
-
-    //========================================================================
-    // 2-bit Slice Lane Mapping
-    // Maps raw data to win_act2 according to slice-major order
-    // Formula: lane = slice * IC_CH_PER_CYCLE + channel
-    //========================================================================
+    
+    // Column rd_col of the window from the row memories; border taps of a
+    // padded layer read as cfg_pad_code. Elements are mapped to lanes
+    // slice-major: lane = slice * IC_CH_PER_CYCLE + ch
+    logic [1:0] rd_colv [0:2][0:IC2_LANES-1];   // [kh][lane]
+    logic [1:0] pre_col [0:1][0:2][0:IC2_LANES-1];
+    integer kh_i, kw_i, ch_i, sl_i;
     
     always_comb begin
-        // Local variable declaration and initialization
-        int lane_idx;
-        lane_idx = 0;
+        logic [ROW_BITS-1:0]   elem;
+        logic [ELEM_CNT_W-1:0] read_addr;
         
-        // Default assignment
-        for (int y = 0; y < 3; y++) begin
-            for (int x = 0; x < 3; x++) begin
-                for (int lane = 0; lane < IC2_LANES; lane++) begin
-                    win_act2[y][x][lane] = 2'b00;
+        for (kh_i = 0; kh_i < 3; kh_i++) begin
+            for (ch_i = 0; ch_i < IC2_LANES; ch_i++)
+                rd_colv[kh_i][ch_i] = 2'b00;
+            for (ch_i = 0; ch_i < 16; ch_i++) begin
+                elem = '0;
+                read_addr = col_addr[rd_col] + ic_base + ELEM_CNT_W'(ch_i);
+                if (ch_i < r_IC_CH_PER_CYCLE) begin
+                    if (tap_y_in[kh_i] && tap_x_in[rd_col])
+                        elem = row_mem[rd_row_idx[kh_i]][read_addr[BANK_W-1:0]]
+                                      [read_addr >> BANK_W];
+                    else
+                        elem = r_pad_code;
+                    for (sl_i = 0; sl_i < 8; sl_i++) begin
+                        if (sl_i < r_act_slices)
+                            rd_colv[kh_i][sl_i * r_IC_CH_PER_CYCLE + ch_i] = elem[2*sl_i +: 2];
+                    end
                 end
             end
         end
+    end
+    
+    // Border taps are masked unless cfg_pad_use_code. Slot s of col_hist
+    // takes column s + 1 of each window.
+    always_ff @(posedge clk) begin
+        if (pre_rd)
+            pre_col[rd_col[0]] <= rd_colv;
         
-        // Map slices: slice-major order
-        for (int y = 0; y < 3; y++) begin
-            for (int x = 0; x < 3; x++) begin
-                for (int slice = 0; slice < 8; slice++) begin
-                    if (slice < r_act_slices) begin
-                        for (int ch = 0; ch < 16; ch++) begin
-                            if (ch < r_IC_CH_PER_CYCLE) begin
-                                lane_idx = slice * r_IC_CH_PER_CYCLE + ch;
-                                if (lane_idx < IC2_LANES) begin
-                                    win_act2[y][x][lane_idx] = raw_win[y][x][ch][2*slice +: 2];
-                                end
-                            end
-                        end
-                    end
+        if (win_load) begin
+            logic [1:0] col [0:IC2_LANES-1];
+            
+            r_win_y <= out_y;
+            r_win_x <= layer_ox;
+            r_win_ic_grp <= out_ic_grp;
+            for (kh_i = 0; kh_i < 3; kh_i++) begin
+                for (kw_i = 0; kw_i < 3; kw_i++) begin
+                    raw_mask[kh_i][kw_i] <= (tap_y_in[kh_i] && tap_x_in[kw_i]) || r_pad_use_code;
+                    
+                    if (kw_i < reuse_cols)
+                        col = col_hist[hist_idx][kw_i + r_stride][kh_i];
+                    else if (kw_i < 2)
+                        col = pre_col[kw_i][kh_i];
+                    else
+                        col = rd_colv[kh_i];
+                    
+                    win_reg[kh_i][kw_i] <= col;
+                    if (kw_i > 0)
+                        col_hist[hist_idx][kw_i - 1][kh_i] <= col;
                 end
             end
         end
     end
+    
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n)
+            win_valid_r <= 1'b0;
+        else if (state == ST_IDLE)
+            win_valid_r <= 1'b0;
+        else if (win_load)
+            win_valid_r <= 1'b1;
+        else if (win_ready)
+            win_valid_r <= 1'b0;
+    end
 
     //========================================================================
     // Output Control
     //========================================================================
     
-    // Valid when in processing state and have valid window coordinates
-    assign win_valid = ((state == ST_PROCESS_WIN) || (state == ST_DRAIN)) && 
-                       (out_y < r_OH) && (r_OH > 16'd0);
+    assign win_valid = win_valid_r;
+    assign win_act2 = win_reg;
+    assign win_mask = raw_mask;
     
-    // Output coordinates
-    assign win_y = out_y;
-    assign win_x = out_x;
-    assign win_ic_grp = out_ic_grp;
+    // Output coordinates of the registered window
+    assign win_y = r_win_y;
+    assign win_x = r_win_x;
+    assign win_ic_grp = r_win_ic_grp;
     
     // Status outputs
     assign linebuf_ready = (state == ST_PROCESS_WIN) || (state == ST_DRAIN);
@@ -558,15 +770,23 @@ module feature_line_buffer #(
                     cfg_act_bits == 5'd8 || cfg_act_bits == 5'd16)
                 else $error("[feature_line_buffer] Invalid act_bits: %d", cfg_act_bits);
             
-            assert (cfg_W > 0 && cfg_W <= MAX_W)
+            assert (cfg_W > 0 && (cfg_tile_W != 16'd0 || cfg_W <= MAX_W))
                 else $error("[feature_line_buffer] Invalid W: %d (max %d)", cfg_W, MAX_W);
             
+            assert (cfg_tile_W == 16'd0 ||
+                    (cfg_tile_W <= MAX_W && 17'(cfg_tile_x0) + 17'(cfg_tile_W) <= 17'(cfg_W)))
+                else $error("[feature_line_buffer] Invalid tile: x0 %d, W %d (max %d)",
+                            cfg_tile_x0, cfg_tile_W, MAX_W);
+            
             assert (cfg_H > 0 && cfg_H <= MAX_H)
                 else $error("[feature_line_buffer] Invalid H: %d (max %d)", cfg_H, MAX_H);
             
             assert (cfg_IC > 0 && cfg_IC <= MAX_IC)
                 else $error("[feature_line_buffer] Invalid IC: %d (max %d)", cfg_IC, MAX_IC);
                 
+            assert (ACT_FIFO_DEPTH >= 2 && (ACT_FIFO_DEPTH & (ACT_FIFO_DEPTH - 1)) == 0)
+                else $error("[feature_line_buffer] ACT_FIFO_DEPTH (%d) not a power of 2", ACT_FIFO_DEPTH);
+            
             assert ((IC2_LANES % calc_slices(cfg_act_bits)) == 0)
                 else $error("[feature_line_buffer] IC2_LANES (%d) not divisible by act_slices (%d)", 
                            IC2_LANES, calc_slices(cfg_act_bits));
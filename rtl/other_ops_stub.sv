@@ -1,43 +1,229 @@
 // other_ops_stub.sv
-// MVP 占位模块：pass-through 直通
-// 后续扩展：bias add、BN fold、ReLU、低比特量化等
+// 后处理单元：bias add + BN fold + ReLU + 按通道重量化，3 级流水，每拍一组向量
+//
+// 向量接口：每次握手传递一组 LANES 个通道 (累加器一次产出的 OC_CH_PER_CYCLE 个结果)，
+// in_count 为本组有效通道数，有效元素位于 [0, in_count)，第 i 个元素对应输出通道
+// in_oc_base + i。
+//
+// 后处理 (cfg_out_bits ∈ {2,4,8,16})：
+//   v    = acc + bias                                 (ACC_W+1 位，不回绕)
+//   t    = (v * scale + 2^(shift-1)) >>> shift        (shift = 0 时不加舍入项)
+//   t    = cfg_relu ? max(t, 0) : t
+//   code = clamp((t + 2^bits - 1) >>> 1, 0, 2^bits - 1)
+// BN 折叠为 bias/scale：gamma*(acc-mean)/sqrt(var+eps)+beta = m*(acc+b)，
+// scale/shift 为 m 的定点表示 (m ≈ scale / 2^shift)。
+// code 即 feature_line_buffer 的激活编码 (各 2-bit slice 经 decode2 后按 4^s 合成
+// 得到值 2*code - (2^bits - 1))，即把 t 落到奇数网格上，输出可直接作为下一层激活。
+// cfg_out_bits = 32 时输出 ACC_W 累加值，不加 bias、不重量化；cfg_relu 仍有效，负值输出 0。
+//
+// 流水线：S1 读参数并加 bias，S2 乘 scale，S3 舍入/移位/ReLU/饱和后寄存输出。
+// 三级同步推进，输出被反压时整体停顿，out_ready 常高时每拍接收一组。
+//
+// bias/scale/shift 按输出通道存放，共两套：当前层读 prm_rd_bank，同时可向另一套
+// 写入下一层的参数 (与下一层权重的载入同时进行)。每套参数按通道 oc 存在 bank
+// oc % LANES 的地址 oc / LANES，与顶层 acc_mem 相同。一组通道 in_oc_base + i 连续且
+// 不跨行 (in_oc_base 为 in_count 的整数倍，in_count 整除 LANES)，各 bank 读同一行，
+// 再按 in_oc_base % LANES 循环移位到 lane；每个 bank 一个读口、一个写口，可映射为 RAM。
 
 module other_ops_stub #(
-    parameter int ACC_W   = 32,
-    parameter int OUT_BITS = 32
+    parameter int ACC_W    = 32,
+    parameter int OUT_BITS = 32,
+    parameter int LANES    = 16,
+    parameter int CNT_W    = $clog2(LANES + 1),
+    parameter int MAX_OC   = 256
 )(
     // 时钟复位
     input  logic        clk,
     input  logic        rst_n,
 
+    // 配置
+    input  logic [5:0]                  cfg_out_bits,   // 2/4/8/16，32 = 原样输出
+    input  logic                        cfg_relu,
+
+    // 后处理参数
+    input  logic                        prm_rd_bank,
+    input  logic                        prm_wr_valid,
+    input  logic                        prm_wr_bank,
+    input  logic [15:0]                 prm_wr_oc,
+    input  logic signed [ACC_W-1:0]     prm_wr_bias,
+    input  logic signed [15:0]          prm_wr_scale,
+    input  logic [4:0]                  prm_wr_shift,
+
     // 输入
     input  logic                        in_valid,
     output logic                        in_ready,
-    input  logic signed [ACC_W-1:0]     in_data,
+    input  logic signed [ACC_W-1:0]     in_data [0:LANES-1],
+    input  logic [CNT_W-1:0]            in_count,
+    input  logic [15:0]                 in_oc_base,
     input  logic                        in_last,
 
     // 输出
     output logic                        out_valid,
     input  logic                        out_ready,
-    output logic signed [OUT_BITS-1:0]  out_data,
+    output logic signed [OUT_BITS-1:0]  out_data [0:LANES-1],
+    output logic [CNT_W-1:0]            out_count,
     output logic                        out_last
 );
 
-    // MVP: 简单打一拍，保持 valid/ready 握手语义
+    localparam int SUM_W  = ACC_W + 1;
+    localparam int PROD_W = SUM_W + 16;
+    localparam int PRM_DEPTH = (MAX_OC + LANES - 1) / LANES;
+    localparam int PRM_AW    = $clog2(PRM_DEPTH);
+    localparam int LANE_W    = $clog2(LANES);
+    
+    //========================================================================
+    // 参数存储：[套][bank = oc % LANES][行 = oc / LANES]
+    //========================================================================
+    logic signed [ACC_W-1:0] prm_bias  [0:1][0:LANES-1][0:PRM_DEPTH-1];
+    logic signed [15:0]      prm_scale [0:1][0:LANES-1][0:PRM_DEPTH-1];
+    logic [4:0]              prm_shift [0:1][0:LANES-1][0:PRM_DEPTH-1];
+    
+    logic [LANE_W-1:0] prm_wr_lane;
+    logic [PRM_AW-1:0] prm_wr_row;
+    
+    assign prm_wr_lane = LANE_W'(prm_wr_oc % 16'(LANES));
+    assign prm_wr_row  = PRM_AW'(prm_wr_oc / 16'(LANES));
+    
+    always_ff @(posedge clk) begin
+        if (prm_wr_valid && prm_wr_oc < 16'(MAX_OC)) begin
+            prm_bias[prm_wr_bank][prm_wr_lane][prm_wr_row]  <= prm_wr_bias;
+            prm_scale[prm_wr_bank][prm_wr_lane][prm_wr_row] <= prm_wr_scale;
+            prm_shift[prm_wr_bank][prm_wr_lane][prm_wr_row] <= prm_wr_shift;
+        end
+    end
+    
+    // 各 bank 读本组所在的行 (bank 顺序)
+    logic [PRM_AW-1:0]       prm_rd_row;
+    logic [LANE_W-1:0]       prm_rd_rot;        // 本组通道 0 所在的 bank
+    logic signed [ACC_W-1:0] rd_bias  [0:LANES-1];
+    logic signed [15:0]      rd_scale [0:LANES-1];
+    logic [4:0]              rd_shift [0:LANES-1];
+    
+    assign prm_rd_row = PRM_AW'(in_oc_base / 16'(LANES));
+    assign prm_rd_rot = LANE_W'(in_oc_base % 16'(LANES));
+    
+    always_comb begin
+        for (int b = 0; b < LANES; b++) begin
+            rd_bias[b]  = prm_bias[prm_rd_bank][b][prm_rd_row];
+            rd_scale[b] = prm_scale[prm_rd_bank][b][prm_rd_row];
+            rd_shift[b] = prm_shift[prm_rd_bank][b][prm_rd_row];
+        end
+    end
+    
+    //========================================================================
+    // 流水线控制：输出未被反压时各级同时推进
+    //========================================================================
+    logic adv;
+    logic s1_valid, s2_valid;
+    logic [CNT_W-1:0] s1_count, s2_count;
+    logic s1_last, s2_last;
+    
+    assign adv      = out_ready || !out_valid;
+    assign in_ready = adv;
+    
+    //========================================================================
+    // S1：读参数，加 bias
+    //========================================================================
+    logic signed [SUM_W-1:0]  s1_sum   [0:LANES-1];
+    logic signed [15:0]       s1_scale [0:LANES-1];
+    logic [4:0]               s1_shift [0:LANES-1];
+    
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            s1_valid <= 1'b0;
+            s1_count <= '0;
+            s1_last  <= 1'b0;
+            for (int i = 0; i < LANES; i++) begin
+                s1_sum[i]   <= '0;
+                s1_scale[i] <= '0;
+                s1_shift[i] <= '0;
+            end
+        end else if (adv) begin
+            s1_valid <= in_valid;
+            s1_count <= in_count;
+            s1_last  <= in_last;
+            for (int i = 0; i < LANES; i++) begin
+                if (cfg_out_bits == 6'd32) begin
+                    s1_sum[i]   <= SUM_W'(in_data[i]);
+                    s1_scale[i] <= 16'sd1;
+                    s1_shift[i] <= 5'd0;
+                end else begin
+                    s1_sum[i]   <= SUM_W'(in_data[i]) +
+                                   SUM_W'(rd_bias[LANE_W'((int'(prm_rd_rot) + i) % LANES)]);
+                    s1_scale[i] <= rd_scale[LANE_W'((int'(prm_rd_rot) + i) % LANES)];
+                    s1_shift[i] <= rd_shift[LANE_W'((int'(prm_rd_rot) + i) % LANES)];
+                end
+            end
+        end
+    end
+    
+    //========================================================================
+    // S2：乘 scale，加舍入项
+    //========================================================================
+    logic signed [PROD_W-1:0] s2_prod  [0:LANES-1];
+    logic [4:0]               s2_shift [0:LANES-1];
+    
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            s2_valid <= 1'b0;
+            s2_count <= '0;
+            s2_last  <= 1'b0;
+            for (int i = 0; i < LANES; i++) begin
+                s2_prod[i]  <= '0;
+                s2_shift[i] <= '0;
+            end
+        end else if (adv) begin
+            s2_valid <= s1_valid;
+            s2_count <= s1_count;
+            s2_last  <= s1_last;
+            for (int i = 0; i < LANES; i++) begin
+                s2_prod[i]  <= PROD_W'(s1_sum[i]) * PROD_W'(s1_scale[i]) +
+                               ((s1_shift[i] != 5'd0) ? (PROD_W'(1) <<< (s1_shift[i] - 5'd1)) : '0);
+                s2_shift[i] <= s1_shift[i];
+            end
+        end
+    end
+    
+    //========================================================================
+    // S3：移位、ReLU、饱和为激活码
+    //========================================================================
+    function automatic logic [OUT_BITS-1:0] to_code(
+        input logic signed [PROD_W-1:0] prod,
+        input logic [4:0]               shift,
+        input logic                     relu,
+        input logic [5:0]               bits
+    );
+        logic signed [PROD_W-1:0] t, code, code_max;
+        t = prod >>> shift;
+        if (relu && t < 0)
+            t = '0;
+        code_max = (PROD_W'(1) <<< bits) - PROD_W'(1);
+        code = (t + code_max) >>> 1;
+        if (code < 0)
+            code = '0;
+        else if (code > code_max)
+            code = code_max;
+        return OUT_BITS'(code);
+    endfunction
+
     always_ff @(posedge clk or negedge rst_n) begin
         if (!rst_n) begin
             out_valid <= 1'b0;
-            out_data  <= '0;
+            out_count <= '0;
             out_last  <= 1'b0;
-        end else if (out_ready || !out_valid) begin
-            // 下游可接收，或当前无有效数据
-            out_valid <= in_valid;
-            out_data  <= in_data;
-            out_last  <= in_last;
+            for (int i = 0; i < LANES; i++)
+                out_data[i] <= '0;
+        end else if (adv) begin
+            out_valid <= s2_valid;
+            out_count <= s2_count;
+            out_last  <= s2_last;
+            for (int i = 0; i < LANES; i++) begin
+                if (cfg_out_bits == 6'd32)
+                    out_data[i] <= (cfg_relu && s2_prod[i] < 0) ? '0 : OUT_BITS'(s2_prod[i]);
+                else
+                    out_data[i] <= to_code(s2_prod[i], s2_shift[i], cfg_relu, cfg_out_bits);
+            end
         end
     end
 
-    // 上游 ready：下游可接收且当前无有效数据，或下游直接 ready
-    assign in_ready = out_ready || !out_valid;
-
 endmodule
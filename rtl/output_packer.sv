@@ -1,24 +1,39 @@
 //=============================================================================
 // Module: output_packer
-// Description: Pack ACC_W signed results into BUS_W beats for stream output
+// Description: Pack output elements into BUS_W beats for stream output
 //              Follows output layout (oy, ox, oc) with oc innermost
 //
+// Accepts a vector of up to LANES elements per handshake (one accumulator
+// result, in_count valid elements in [0, in_count)) and packs them densely
+// at cfg_out_bits per element: 32 for raw ACC_W values, or 2/4/8/16-bit
+// codes taken from the low bits of each lane. Element i of the layer lands
+// in bits [i*bits +: bits] of the stream, little-endian across beats, which
+// is the act_in_data layout of feature_line_buffer. One beat goes out per
+// cycle; with out_ready high a new vector is accepted as soon as at most
+// one beat is left, so the packer adds no bubbles on the output bus.
+//
 // Based on AGENTS.md §6.4
 //=============================================================================
 
 module output_packer #(
     parameter int ACC_W = 32,           // Accumulator bit width
-    parameter int BUS_W = 128           // Output bus bit width
+    parameter int BUS_W = 128,          // Output bus bit width
+    parameter int LANES = 16,           // Max elements per input vector
+    parameter int CNT_W = $clog2(LANES + 1)
 ) (
     // Clock and reset
     input  logic        clk,
     input  logic        rst_n,
 
-    // Input from conv_core / inter-cycle accumulator
+    // Element width: 2, 4, 8, 16, or 32 (raw ACC_W); held for the layer
+    input  logic [5:0]                  cfg_out_bits,
+
+    // Input from other_ops_stub (one accumulator result per handshake)
     input  logic                        in_valid,
     output logic                        in_ready,
-    input  logic signed [ACC_W-1:0]     in_data,        // Single element
-    input  logic                        in_last,        // Last element of layer
+    input  logic signed [ACC_W-1:0]     in_data [0:LANES-1],
+    input  logic [CNT_W-1:0]            in_count,       // Valid elements in in_data
+    input  logic                        in_last,        // Last vector of layer
 
     // Output to external stream
     output logic                        out_valid,
@@ -30,107 +45,92 @@ module output_packer #(
     //=============================================================================
     // Local parameters
     //=============================================================================
-    localparam int ELEM_PER_BEAT = BUS_W / ACC_W;   // Elements per output beat
-    localparam int CNT_W = $clog2(ELEM_PER_BEAT);   // Counter bit width
+    localparam int VEC_W  = LANES * ACC_W;              // Widest input vector
+    localparam int DEPTH  = VEC_W + BUS_W;              // Buffer bits
+    localparam int FILL_W = $clog2(DEPTH + 1);
 
     //=============================================================================
     // Internal signals
     //=============================================================================
-    // Packing buffer: holds elements until a full beat is formed
-    logic [ACC_W-1:0] pack_buf [0:ELEM_PER_BEAT-1];
+    // Packing buffer: bit 0 goes out first. Bits at and above fill are zero.
+    logic [DEPTH-1:0]  pack_buf;
     
-    // Element counter: how many elements currently in buffer
-    logic [CNT_W-1:0] elem_cnt;
+    // Number of valid bits in pack_buf
+    logic [FILL_W-1:0] fill;
     
-    // Flag indicating this is the final beat (in_last was received)
-    logic             is_last_beat;
+    // The layer's last vector is in pack_buf; its final beat carries out_last
+    logic              last_in_buf;
     
-    // Internal state
-    logic             buf_full;     // Buffer is full (ready to output)
-    logic             flushing;     // In flush mode (sending final partial beat)
-
-    //=============================================================================
-    // Buffer full detection
-    //=============================================================================
-    assign buf_full = (elem_cnt == ELEM_PER_BEAT[CNT_W-1:0]);
-
-    //=============================================================================
-    // Input ready generation
-    // Accept input when:
-    // 1. Buffer is not full, OR
-    // 2. Buffer is full but output is being accepted this cycle (out_valid & out_ready)
-    // However, we need to be careful about backpressure during flushing
-    //=============================================================================
-    assign in_ready = !flushing && (!buf_full || (out_valid && out_ready));
+    logic              beat_pop;    // Output beat accepted this cycle
+    logic              vec_push;    // Input vector accepted this cycle
+    logic [FILL_W-1:0] fill_pop;    // Fill level after this cycle's pop
+    
+    logic [VEC_W-1:0]  in_vec;      // in_data packed at cfg_out_bits
+    logic [FILL_W-1:0] in_nbits;    // Valid bits in in_vec
 
     //=============================================================================
-    // Output data construction (combinational)
-    // Pack buffer elements into BUS_W output with little-endian ordering:
-    // pack_buf[0] -> out_data[ACC_W-1:0] (lowest address)
-    // pack_buf[1] -> out_data[2*ACC_W-1:ACC_W]
-    // ...
-    // pack_buf[ELEM_PER_BEAT-1] -> out_data[BUS_W-1:BUS_W-ACC_W] (highest address)
+    // Input vector packing
     //=============================================================================
     always_comb begin
-        out_data = '0;  // Default to 0 (handles padding for final partial beat)
-        for (int i = 0; i < ELEM_PER_BEAT; i++) begin
-            out_data[i*ACC_W +: ACC_W] = pack_buf[i];
+        in_vec = '0;
+        for (int i = 0; i < LANES; i++) begin
+            if (CNT_W'(i) < in_count) begin
+                case (cfg_out_bits)
+                    6'd2:    in_vec[i*2  +: 2]     = in_data[i][1:0];
+                    6'd4:    in_vec[i*4  +: 4]     = in_data[i][3:0];
+                    6'd8:    in_vec[i*8  +: 8]     = in_data[i][7:0];
+                    6'd16:   in_vec[i*16 +: 16]    = in_data[i][15:0];
+                    default: in_vec[i*ACC_W +: ACC_W] = in_data[i];
+                endcase
+            end
         end
+        in_nbits = FILL_W'(in_count) * FILL_W'(cfg_out_bits);
     end
 
     //=============================================================================
-    // Output valid and last generation
+    // Handshakes
+    // A beat is available once BUS_W bits are buffered, or for the final
+    // partial beat of a layer. A vector is accepted when it fits behind what
+    // remains after this cycle's pop, i.e. at most one beat is left.
     //=============================================================================
-    // Output is valid when:
-    // 1. Buffer is full (normal operation), OR
-    // 2. We're flushing the final partial beat
-    assign out_valid = buf_full || flushing;
+    assign out_valid = (fill >= FILL_W'(BUS_W)) || (last_in_buf && fill != '0);
+    assign out_last  = last_in_buf && (fill <= FILL_W'(BUS_W));
+    assign beat_pop  = out_valid && out_ready;
     
-    // out_last is asserted on the final beat:
-    // 1. Normal case: buffer full and this is the last beat
-    // 2. Flush case: in the middle of flushing
-    assign out_last = (buf_full && is_last_beat) || (flushing && is_last_beat);
+    assign fill_pop  = !beat_pop                 ? fill :
+                       (fill > FILL_W'(BUS_W))   ? fill - FILL_W'(BUS_W) :
+                                                   '0;
+    
+    // Vectors after the last one wait until the final beat has gone out
+    assign in_ready  = !last_in_buf && (fill_pop <= FILL_W'(BUS_W));
+    assign vec_push  = in_valid && in_ready;
+
+    //=============================================================================
+    // Output data: the low BUS_W bits. A final partial beat is zero-padded
+    // since bits past fill are always zero.
+    //=============================================================================
+    assign out_data = pack_buf[BUS_W-1:0];
 
     //=============================================================================
     // Sequential logic: buffer management
+    // Pop shifts the buffer down by one beat; a pushed vector is ORed in right
+    // behind the bits that remain.
     //=============================================================================
     always_ff @(posedge clk or negedge rst_n) begin
         if (!rst_n) begin
-            elem_cnt <= '0;
-            is_last_beat <= 1'b0;
-            flushing <= 1'b0;
-            for (int i = 0; i < ELEM_PER_BEAT; i++) begin
-                pack_buf[i] <= '0;
-            end
+            pack_buf <= '0;
+            fill <= '0;
+            last_in_buf <= 1'b0;
         end else begin
-            // Handle output acceptance
-            if (out_valid && out_ready) begin
-                // Beat was accepted - clear buffer
-                elem_cnt <= '0;
-                if (flushing) begin
-                    // Finished flushing, go back to normal
-                    flushing <= 1'b0;
-                    is_last_beat <= 1'b0;
-                end
-            end
-
-            // Handle input acceptance
-            if (in_valid && in_ready) begin
-                // Store incoming data to current buffer position
-                pack_buf[elem_cnt] <= $unsigned(in_data);
-                
-                // Increment counter
-                elem_cnt <= elem_cnt + 1'b1;
-                
-                // Check if this is the last element
-                if (in_last) begin
-                    is_last_beat <= 1'b1;
-                    // If buffer won't be full after this element, need to flush
-                    if (elem_cnt != ELEM_PER_BEAT[CNT_W-1:0] - 1'b1) begin
-                        flushing <= 1'b1;
-                    end
-                end
-            end
+            pack_buf <= (beat_pop ? (pack_buf >> BUS_W) : pack_buf) |
+                        (vec_push ? (DEPTH'(in_vec) << fill_pop) : '0);
+            
+            fill <= fill_pop + (vec_push ? in_nbits : '0);
+            
+            if (vec_push && in_last)
+                last_in_buf <= 1'b1;
+            else if (beat_pop && out_last)
+                last_in_buf <= 1'b0;
         end
     end
 
@@ -144,13 +144,13 @@ module output_packer #(
                 if (in_last && !in_valid)
                     $error("in_last asserted without in_valid");
                 
-                // Check that element count never exceeds capacity
-                if (elem_cnt > ELEM_PER_BEAT)
-                    $error("elem_cnt overflow");
+                // Check that the vector fits the input lanes
+                if (in_valid && in_count > CNT_W'(LANES))
+                    $error("in_count %0d exceeds LANES", in_count);
                 
-                // Check that flushing state is consistent with is_last_beat
-                if (flushing && !is_last_beat)
-                    $error("flushing without is_last_beat");
+                // Check that the fill level never exceeds capacity
+                if (fill > FILL_W'(DEPTH))
+                    $error("fill overflow");
             end
         end
     `endif
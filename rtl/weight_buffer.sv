@@ -4,7 +4,34 @@
 // 功能：
 //   1. 从外部流加载整层权重 (OC x IC x 3 x 3)
 //   2. 根据请求输出指定 (oc_grp, ic_grp) 的 weight block
+//      (读路径 2 级流水, 每拍接收一个请求, 固定 2 拍延迟)
 //   3. 支持 2/4/8/16 bit 权重，输出统一为 2-bit slice 格式
+//
+// 存储布局 (加载时预切片):
+//   每个 oc lane 一个 bank, 共 OC2_LANES 个; bank 字宽 = KH*KW*IC2_LANES*2 bit,
+//   一个字恰好是该 lane 在一个 (oc_grp, ic_grp) 块内的全部 2-bit 码。
+//   oc lane = g * OC_CH_PER_CYCLE + p 存放物理通道 oc_grp*OC_CH_PER_CYCLE+p
+//   的第 g 个 slice; 字地址 = oc_grp * MAX_IC_GRP + ic_grp;
+//   字内位置 = ((kh*KW + kw) * IC2_LANES + ic%IC2_LANES) * 2。
+//   每个 lane 的字按 kernel 位置再分成 KH*KW 个子 bank, 子 bank 字宽
+//   IC2_LANES*2 = 32 bit, 放一个 (kh, kw) 的 16 个 ic。读一个块时各子 bank
+//   以同一地址各读一个字拼成整字。
+//   加载时每拍只处理流中的一段 (同一 (kh, kw, oc) 且同一 ic 组的连续元素,
+//   不跨 beat), 段凑满一个字 (或到 ic 行末) 后整字写入; 每个子 bank 每拍
+//   至多一次整字写, 读写各一个端口, 可映射为 BRAM / LUTRAM。
+//   一个 beat 含多段时分多拍写完 (2-bit 权重 IC >= 16 时 4 拍/beat,
+//   4-bit 2 拍, 8/16-bit 1 拍), wgt_in_ready 在 beat 的最后一段才拉高。
+//
+// act_bits > 2 时 ic 侧同样按 slice-major 占用 lane (ic lane = s * IC_CH_PER_CYCLE + ch),
+// 一个 ic_grp 只含 IC_CH_PER_CYCLE 个通道, 且每个 act slice 要用同一组权重:
+// 读出时取字内从 (ic_grp * IC_CH_PER_CYCLE) % IC2_LANES 起的 IC_CH_PER_CYCLE 个通道,
+// 复制到各 act slice 的 lane 上。存储布局与 act_bits 无关。
+//
+// 乒乓模式 (PINGPONG=1):
+//   两套 bank + 各自的配置寄存器。加载侧写 ld_buf, 读取侧读 rd_buf;
+//   一层权重加载完成后该 buffer 置满并切换 ld_buf, 下一层配置即可在当前层
+//   卷积期间接收并加载。读取侧用完后由 rd_release 释放并切换 rd_buf。
+//   PINGPONG=0 时只有一套 bank, 行为与单缓冲相同 (释放后才能加载下一层)。
 //============================================================================
 
 module weight_buffer #(
@@ -14,7 +41,8 @@ module weight_buffer #(
     parameter int IC2_LANES   = 16,
     parameter int OC2_LANES   = 16,
     parameter int KH          = 3,
-    parameter int KW          = 3
+    parameter int KW          = 3,
+    parameter int PINGPONG    = 1       // 1: 双缓冲, 0: 单缓冲
 )(
     // 时钟复位
     input  logic        clk,
@@ -24,6 +52,7 @@ module weight_buffer #(
     input  logic [15:0] cfg_IC,
     input  logic [15:0] cfg_OC,
     input  logic [4:0]  cfg_wgt_bits,   // 2,4,8,16
+    input  logic [4:0]  cfg_act_bits,   // 2,4,8,16, 决定读出时的 ic lane 映射
     input  logic        cfg_valid,
     output logic        cfg_ready,
 
@@ -33,6 +62,10 @@ module weight_buffer #(
     input  logic [BUS_W-1:0] wgt_in_data,
     input  logic        wgt_in_last,
     output logic        wgt_load_done,
+    
+    // 读取侧 buffer 状态
+    output logic        rd_buf_ready,   // 当前读 buffer 已装满一层权重
+    input  logic        rd_release,     // 当前层读取完毕, 释放读 buffer
 
     // 输出到 conv_core 的请求接口
     input  logic [7:0]  req_oc_grp,
@@ -50,29 +83,50 @@ module weight_buffer #(
     // 本地参数和类型定义
     //========================================================================
     
-    // 计算最大存储深度: MAX_OC * MAX_IC * 9
-    localparam int MAX_ELEMENTS = MAX_OC * MAX_IC * KH * KW;
-    localparam int ADDR_W       = $clog2(MAX_ELEMENTS);
+    // 最大位宽 / slice 数
+    localparam int MAX_WGT_BITS   = 16;
+    localparam int MAX_WGT_SLICES = MAX_WGT_BITS / 2;
+    
+    // bank 组织: 字宽为一个 lane 的一个块, 深度按 16-bit 权重 (oc_grp 最多) 计算
+    localparam int BANK_W      = KH * KW * IC2_LANES * 2;
+    localparam int WORD_W      = IC2_LANES * 2;     // 子 bank 字宽
+    localparam int SEG_W       = $clog2(IC2_LANES + 1);
+    localparam int MAX_IC_GRP  = (MAX_IC + IC2_LANES - 1) / IC2_LANES;
+    localparam int MAX_OC_GRP  = (MAX_OC * MAX_WGT_SLICES + OC2_LANES - 1) / OC2_LANES;
+    localparam int BANK_DEPTH  = MAX_OC_GRP * MAX_IC_GRP;
+    localparam int BANK_ADDR_W = $clog2(BANK_DEPTH);
     
-    // 最大位宽
-    localparam int MAX_WGT_BITS = 16;
+    localparam int NUM_BUF = PINGPONG ? 2 : 1;
     
     //========================================================================
-    // 配置寄存器
+    // 配置寄存器 (每个 buffer 一套)
     //========================================================================
+    logic [15:0] buf_IC [0:NUM_BUF-1];
+    logic [15:0] buf_OC [0:NUM_BUF-1];
+    logic [4:0]  buf_wgt_bits [0:NUM_BUF-1];
+    logic [4:0]  buf_act_bits [0:NUM_BUF-1];
+    logic        buf_full [0:NUM_BUF-1];
+    
+    logic        ld_buf;              // 加载侧写入的 buffer
+    logic        rd_buf;              // 读取侧使用的 buffer
+    
+    // 加载侧配置 (buf_*[ld_buf])
     logic [15:0] reg_IC, reg_OC;
     logic [4:0]  reg_wgt_bits;
-    logic [2:0]  reg_wgt_slices;      // wgt_bits / 2
+    logic [3:0]  reg_wgt_slices;      // wgt_bits / 2
     logic [7:0]  reg_OC_CH_PER_CYCLE; // OC2_LANES / wgt_slices
-    logic [7:0]  reg_IC_CH_PER_CYCLE; // IC2_LANES (when act_bits==2)
+    logic [2:0]  reg_oc_shift;        // log2(OC_CH_PER_CYCLE)
     
     // 派生配置
     logic [31:0] total_elements;      // OC * IC * 9
     
+    // 读取侧配置 (buf_*[rd_buf])
+    logic [7:0]  rd_IC_CH_PER_CYCLE;  // IC2_LANES / act_slices
+    
     //========================================================================
-    // RAM 存储 (inferred dual-port: 1 write, 1 read)
+    // Bank 存储 (每个 lane 的每个 kernel 位置一个子 bank, 1 写 1 读)
     //========================================================================
-    logic [MAX_WGT_BITS-1:0] wgt_ram [0:MAX_ELEMENTS-1];
+    logic [WORD_W-1:0] wgt_bank [0:NUM_BUF-1][0:OC2_LANES-1][0:KH*KW-1][0:BANK_DEPTH-1];
     
     //========================================================================
     // 加载状态机和逻辑
@@ -84,265 +138,370 @@ module weight_buffer #(
     } load_state_t;
     
     load_state_t load_state;
-    logic [ADDR_W-1:0] load_addr;        // 当前写入地址
     logic [31:0]       load_element_cnt; // 已加载元素计数
     logic [31:0]       beat_cnt;         // 当前 beat 计数
     
+    // 当前段首元素的坐标 (流顺序 kh -> kw -> oc -> ic, ic 最快)
+    logic [15:0]       ld_ic, ld_oc;
+    logic [3:0]        ld_k;             // kh*KW + kw
+    
     // 计算配置派生值 (组合逻辑)
     always_comb begin
+        reg_IC = buf_IC[ld_buf];
+        reg_OC = buf_OC[ld_buf];
+        reg_wgt_bits = buf_wgt_bits[ld_buf];
+        rd_IC_CH_PER_CYCLE = IC2_LANES / buf_act_bits[rd_buf][4:1];
+        
         reg_wgt_slices = reg_wgt_bits[4:1];  // div by 2
         reg_OC_CH_PER_CYCLE = OC2_LANES / reg_wgt_slices;
-        reg_IC_CH_PER_CYCLE = IC2_LANES;
         total_elements = reg_OC * reg_IC * KH * KW;
+        case (reg_wgt_bits)
+            5'd2:    reg_oc_shift = 3'($clog2(OC2_LANES));
+            5'd4:    reg_oc_shift = 3'($clog2(OC2_LANES / 2));
+            5'd8:    reg_oc_shift = 3'($clog2(OC2_LANES / 4));
+            default: reg_oc_shift = 3'($clog2(OC2_LANES / 8));
+        endcase
     end
     
     // 配置接口处理
+    // 加载空闲且 ld_buf 未被占用时接收配置, 接收的同一拍即进入 LOAD_ACTIVE
+    assign cfg_ready = (load_state == LOAD_IDLE) && !buf_full[ld_buf];
+    
     always_ff @(posedge clk or negedge rst_n) begin
         if (!rst_n) begin
-            reg_IC <= '0;
-            reg_OC <= '0;
-            reg_wgt_bits <= '0;
-            cfg_ready <= 1'b1;
+            for (int b = 0; b < NUM_BUF; b++) begin
+                buf_IC[b] <= '0;
+                buf_OC[b] <= '0;
+                buf_wgt_bits[b] <= 5'd2;
+                buf_act_bits[b] <= 5'd2;
+            end
         end else begin
             if (cfg_valid && cfg_ready) begin
-                reg_IC <= cfg_IC;
-                reg_OC <= cfg_OC;
-                reg_wgt_bits <= cfg_wgt_bits;
-                cfg_ready <= 1'b0;
-            end else if (load_state == LOAD_DONE) begin
-                cfg_ready <= 1'b1;
+                buf_IC[ld_buf] <= cfg_IC;
+                buf_OC[ld_buf] <= cfg_OC;
+                buf_wgt_bits[ld_buf] <= cfg_wgt_bits;
+                buf_act_bits[ld_buf] <= cfg_act_bits;
             end
         end
     end
     
-    // 位宽解析函数
-    function automatic logic [MAX_WGT_BITS-1:0] extract_element(
-        input logic [BUS_W-1:0] data,
-        input logic [5:0]       idx,
-        input logic [4:0]       bits
-    );
+    // buffer 占用状态: 加载完成置满, 读取侧释放清空
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            for (int b = 0; b < NUM_BUF; b++) begin
+                buf_full[b] <= 1'b0;
+            end
+            ld_buf <= 1'b0;
+            rd_buf <= 1'b0;
+        end else begin
+            if (load_state == LOAD_DONE) begin
+                buf_full[ld_buf] <= 1'b1;
+                if (PINGPONG != 0)
+                    ld_buf <= !ld_buf;
+            end
+            if (rd_release && buf_full[rd_buf]) begin
+                buf_full[rd_buf] <= 1'b0;
+                if (PINGPONG != 0)
+                    rd_buf <= !rd_buf;
+            end
+        end
+    end
+    
+    assign rd_buf_ready = buf_full[rd_buf];
+    
+    // 计算每 beat 元素数 (2-bit 时为 64, 需要 7 位)
+    function automatic logic [6:0] elems_per_beat(input logic [4:0] bits);
+        return (BUS_W / bits);
+    endfunction
+    
+    function automatic logic [2:0] bits_log2(input logic [4:0] bits);
         case (bits)
-            5'd2:  return data[idx*2 +: 2];
-            5'd4:  return data[idx*4 +: 4];
-            5'd8:  return data[idx*8 +: 8];
-            5'd16: return data[idx*16 +: 16];
-            default: return '0;
+            5'd4:    return 3'd2;
+            5'd8:    return 3'd3;
+            5'd16:   return 3'd4;
+            default: return 3'd1;
         endcase
     endfunction
     
-    // 计算每 beat 元素数
-    function automatic logic [5:0] elems_per_beat(input logic [4:0] bits);
-        return (BUS_W / bits);
+    //------------------------------------------------------------------------
+    // 当前段: 从 beat 内第 beat_pos 个元素起, 坐标 (ld_k, ld_oc, ld_ic) 起的
+    // seg_n 个元素, 到 beat 末、ic 组末 (ic % IC2_LANES 回到 0)、ic 行末或
+    // 整层末为止。段内元素落在字内 slot ic%IC2_LANES 起的连续位置。
+    //------------------------------------------------------------------------
+    logic [6:0]        beat_pos;         // 当前 beat 已写入的元素数
+    logic [SEG_W-1:0]  seg_n;
+    logic [3:0]        seg_off;          // ld_ic % IC2_LANES
+    logic              seg_word_end;     // 段结束时字写满 (或到 ic 行末)
+    logic              seg_beat_end;     // 段结束时 beat 用完
+    logic              seg_fire;
+    logic [BUS_W-1:0]  seg_shift;        // beat 右移 beat_pos 个元素
+    logic [MAX_WGT_BITS-1:0] seg_val [0:IC2_LANES-1];
+    
+    always_comb begin
+        logic [31:0] n;
+        n = 32'(elems_per_beat(reg_wgt_bits) - beat_pos);
+        seg_off = 4'(ld_ic % IC2_LANES);
+        if (n > 32'(IC2_LANES) - 32'(seg_off))
+            n = 32'(IC2_LANES) - 32'(seg_off);
+        if (n > 32'(reg_IC - ld_ic))
+            n = 32'(reg_IC - ld_ic);
+        if (n > total_elements - load_element_cnt)
+            n = total_elements - load_element_cnt;
+        seg_n = SEG_W'(n);
+        seg_word_end = (32'(seg_off) + n == 32'(IC2_LANES)) || (32'(ld_ic) + n == 32'(reg_IC));
+        seg_beat_end = (32'(beat_pos) + n == 32'(elems_per_beat(reg_wgt_bits))) ||
+                       (load_element_cnt + n >= total_elements);
+        seg_shift = wgt_in_data >> (32'(beat_pos) << bits_log2(reg_wgt_bits));
+    end
+    
+    // 段内第 j 个元素 (总线上元素 i 位于 [i*bits +: bits])
+    generate
+        genvar sj;
+        for (sj = 0; sj < IC2_LANES; sj++) begin : gen_seg_val
+            logic [MAX_WGT_BITS-1:0] v4, v8, v16;
+            if (sj < BUS_W / 4) begin : g_v4
+                assign v4 = MAX_WGT_BITS'(seg_shift[sj*4 +: 4]);
+            end else begin : g_n4
+                assign v4 = '0;
+            end
+            if (sj < BUS_W / 8) begin : g_v8
+                assign v8 = MAX_WGT_BITS'(seg_shift[sj*8 +: 8]);
+            end else begin : g_n8
+                assign v8 = '0;
+            end
+            if (sj < BUS_W / 16) begin : g_v16
+                assign v16 = seg_shift[sj*16 +: 16];
+            end else begin : g_n16
+                assign v16 = '0;
+            end
+            always_comb begin
+                case (reg_wgt_bits)
+                    5'd4:    seg_val[sj] = v4;
+                    5'd8:    seg_val[sj] = v8;
+                    5'd16:   seg_val[sj] = v16;
+                    default: seg_val[sj] = MAX_WGT_BITS'(seg_shift[sj*2 +: 2]);
+                endcase
+            end
+        end
+    endgenerate
+    
+    assign seg_fire = (load_state == LOAD_ACTIVE) && wgt_in_valid;
+    
+    // beat 在最后一段写入的同一拍被接收
+    assign wgt_in_ready = (load_state == LOAD_ACTIVE) && seg_beat_end;
+    
+    // 元素所在块的 bank 字地址
+    function automatic logic [BANK_ADDR_W-1:0] bank_addr(
+        input logic [15:0] oc,
+        input logic [15:0] ic
+    );
+        return BANK_ADDR_W'((oc >> reg_oc_shift) * MAX_IC_GRP + (ic / IC2_LANES));
     endfunction
     
     // 加载状态机
     always_ff @(posedge clk or negedge rst_n) begin
         if (!rst_n) begin
             load_state <= LOAD_IDLE;
-            load_addr <= '0;
             load_element_cnt <= '0;
             beat_cnt <= '0;
+            beat_pos <= '0;
+            ld_ic <= '0;
+            ld_oc <= '0;
+            ld_k <= '0;
             wgt_load_done <= 1'b0;
         end else begin
             wgt_load_done <= 1'b0;
-            
+    
             case (load_state)
                 LOAD_IDLE: begin
-                    if (cfg_valid && !cfg_ready) begin
+                    if (cfg_valid && cfg_ready) begin
                         load_state <= LOAD_ACTIVE;
-                        load_addr <= '0;
                         load_element_cnt <= '0;
                         beat_cnt <= '0;
+                        beat_pos <= '0;
+                        ld_ic <= '0;
+                        ld_oc <= '0;
+                        ld_k <= '0;
                     end
                 end
-                
+    
                 LOAD_ACTIVE: begin
-                    if (wgt_in_valid && wgt_in_ready) begin
-                        beat_cnt <= beat_cnt + 1;
-                        
-                        // 解析并写入当前 beat 的数据
-                        // 使用 generate 风格的循环展开
-                        for (int i = 0; i < 64; i++) begin
-                            if (i < elems_per_beat(reg_wgt_bits) && 
-                                load_element_cnt + i < total_elements) begin
-                                wgt_ram[load_addr + i] <= extract_element(
-                                    wgt_in_data, i[5:0], reg_wgt_bits
-                                );
+                    if (seg_fire) begin
+                        load_element_cnt <= load_element_cnt + 32'(seg_n);
+                        beat_pos <= seg_beat_end ? 7'd0 : beat_pos + 7'(seg_n);
+                        if (seg_beat_end)
+                            beat_cnt <= beat_cnt + 1;
+    
+                        // 下一段起点 (流顺序 kh -> kw -> oc -> ic)
+                        if (ld_ic + 16'(seg_n) >= reg_IC) begin
+                            ld_ic <= '0;
+                            if (ld_oc + 16'd1 >= reg_OC) begin
+                                ld_oc <= '0;
+                                ld_k <= ld_k + 4'd1;
+                            end else begin
+                                ld_oc <= ld_oc + 16'd1;
                             end
+                        end else begin
+                            ld_ic <= ld_ic + 16'(seg_n);
                         end
-                        
-                        load_addr <= load_addr + elems_per_beat(reg_wgt_bits);
-                        load_element_cnt <= load_element_cnt + elems_per_beat(reg_wgt_bits);
-                        
-                        if (wgt_in_last || 
-                            load_element_cnt + elems_per_beat(reg_wgt_bits) >= total_elements) begin
+    
+                        if ((seg_beat_end && wgt_in_last) ||
+                            load_element_cnt + 32'(seg_n) >= total_elements) begin
                             load_state <= LOAD_DONE;
                         end
                     end
                 end
-                
+    
                 LOAD_DONE: begin
                     wgt_load_done <= 1'b1;
                     load_state <= LOAD_IDLE;
                 end
-                
+    
                 default: load_state <= LOAD_IDLE;
             endcase
         end
     end
     
-    assign wgt_in_ready = (load_state == LOAD_ACTIVE);
+    //------------------------------------------------------------------------
+    // 字拼装: 跨 beat 的字先在 seg_stage 中收集, 段结束字写满时与本段合并
+    // 整字写入。元素的 slice g 写入 lane g*OC_CH_PER_CYCLE + oc%OC_CH_PER_CYCLE
+    // 的 (kh, kw) 子 bank; 各 slice 的 lane 互不相同, 每个子 bank 每拍至多写一次。
+    // 字内 IC 以外的 slot 不会被读取, 内容无关。
+    //------------------------------------------------------------------------
+    logic [MAX_WGT_BITS-1:0] seg_stage [0:IC2_LANES-1];
+    logic [MAX_WGT_BITS-1:0] word_val  [0:IC2_LANES-1];
+    
+    always_comb begin
+        for (int s = 0; s < IC2_LANES; s++) begin
+            if (s >= int'(seg_off) && s < int'(seg_off) + int'(seg_n))
+                word_val[s] = seg_val[s - int'(seg_off)];
+            else
+                word_val[s] = seg_stage[s];
+        end
+    end
+    
+    always_ff @(posedge clk) begin
+        if (seg_fire && !seg_word_end) begin
+            for (int s = 0; s < IC2_LANES; s++)
+                seg_stage[s] <= word_val[s];
+        end
+    end
+    
+    logic [BANK_ADDR_W-1:0] seg_addr;
+    assign seg_addr = bank_addr(ld_oc, ld_ic);
+    
+    generate
+        genvar wl, wk;
+        for (wl = 0; wl < OC2_LANES; wl++) begin : gen_bank_wr
+            // lane wl 存放 slice wl / OC_CH_PER_CYCLE 的物理通道 wl % OC_CH_PER_CYCLE
+            logic [3:0]        wl_slice;
+            logic              wl_hit;
+            logic [WORD_W-1:0] wl_word;
+    
+            always_comb begin
+                wl_slice = 4'(wl >> reg_oc_shift);
+                wl_hit = (wl_slice < reg_wgt_slices) &&
+                         (16'(wl) & 16'(reg_OC_CH_PER_CYCLE - 8'd1)) ==
+                         (ld_oc & 16'(reg_OC_CH_PER_CYCLE - 8'd1));
+                for (int s = 0; s < IC2_LANES; s++)
+                    wl_word[s*2 +: 2] = word_val[s][wl_slice*2 +: 2];
+            end
+    
+            for (wk = 0; wk < KH*KW; wk++) begin : gen_k
+                always_ff @(posedge clk) begin
+                    if (seg_fire && seg_word_end && wl_hit && ld_k == 4'(wk))
+                        wgt_bank[ld_buf][wl][wk][seg_addr] <= wl_word;
+                end
+            end
+        end
+    endgenerate
     
     //========================================================================
-    // 权重读取逻辑
+    // 权重读取逻辑 (2 级流水, 每拍可接收一个 (oc_grp, ic_grp) 请求)
+    //   S1: 锁存请求, 计算 bank 字地址
+    //   S2: 所有 bank 以同一地址各读一个字, 拆成 wgt2 格式打入输出寄存器
+    // 无反压时请求被接收后固定 READ_LAT 拍出现在 wgt2/wgt_valid 上;
+    // wgt_ready 为低时整条流水线原地保持, 请求不丢不重。
     //========================================================================
+    localparam int READ_LAT = 2;
     
-    // 读取状态
-    typedef enum logic [1:0] {
-        READ_IDLE,
-        READ_ACTIVE,
-        READ_DONE
-    } read_state_t;
-    
-    read_state_t read_state_reg;
-    logic [7:0]  read_oc_grp_reg, read_ic_grp_reg;
-    logic [7:0]  read_oc_base, read_ic_base;
+    logic                   s1_valid;
+    logic [BANK_ADDR_W-1:0] s1_addr;
+    logic [3:0]             s1_ic_off;    // 块内首通道在字内的位置
+    logic [3:0]             s1_ch_mask;   // IC_CH_PER_CYCLE - 1
+    logic                   s1_load, s2_load;
     
-    // 输出缓冲
+    // S2 输出寄存器
     logic [1:0]  wgt2_reg [0:OC2_LANES-1][0:KH-1][0:KW-1][0:IC2_LANES-1];
     logic        wgt_valid_reg;
     
-    // 地址计算函数
-    // addr = (((kh*3)+kw)*OC + oc)*IC + ic
-    function automatic logic [ADDR_W-1:0] calc_wgt_addr(
-        input logic [15:0] oc,
-        input logic [15:0] ic,
-        input logic [1:0]  kh,
-        input logic [1:0]  kw
-    );
-        return ((kh * 3 + kw) * reg_OC + oc) * reg_IC + ic;
-    endfunction
-    
-    // 从存储值中提取指定 slice 的 2-bit
-    function automatic logic [1:0] get_slice(
-        input logic [MAX_WGT_BITS-1:0] value,
-        input logic [2:0]              slice_idx
-    );
-        return value[slice_idx*2 +: 2];
-    endfunction
+    // 流水线推进条件: 下一级为空或本拍被取走
+    assign s2_load   = !wgt_valid_reg || wgt_ready;
+    assign s1_load   = !s1_valid || s2_load;
+    assign req_ready = s1_load;
     
-    // 读取状态机
+    // S1: 请求寄存器
     always_ff @(posedge clk or negedge rst_n) begin
         if (!rst_n) begin
-            read_state_reg <= READ_IDLE;
-            wgt_valid_reg <= 1'b0;
-            read_oc_grp_reg <= '0;
-            read_ic_grp_reg <= '0;
-            read_oc_base <= '0;
-            read_ic_base <= '0;
+            s1_valid <= 1'b0;
+            s1_addr <= '0;
+            s1_ic_off <= '0;
+            s1_ch_mask <= '0;
         end else begin
-            wgt_valid_reg <= 1'b0;
-            
-            case (read_state_reg)
-                READ_IDLE: begin
-                    if (req_valid && req_ready) begin
-                        read_state_reg <= READ_ACTIVE;
-                        read_oc_grp_reg <= req_oc_grp;
-                        read_ic_grp_reg <= req_ic_grp;
-                        read_oc_base <= req_oc_grp * reg_OC_CH_PER_CYCLE;
-                        read_ic_base <= req_ic_grp * IC2_LANES;
-                    end
-                end
-                
-                READ_ACTIVE: begin
-                    read_state_reg <= READ_DONE;
+            if (s1_load) begin
+                s1_valid <= req_valid;
+                if (req_valid) begin
+                    // 块首通道 ic0 = ic_grp * IC_CH_PER_CYCLE, 所在字 ic0 / IC2_LANES
+                    logic [15:0] ic0;
+                    ic0 = 16'(req_ic_grp) * 16'(rd_IC_CH_PER_CYCLE);
+                    s1_addr <= BANK_ADDR_W'(req_oc_grp * MAX_IC_GRP + ic0 / IC2_LANES);
+                    s1_ic_off <= 4'(ic0 % IC2_LANES);
+                    s1_ch_mask <= 4'(rd_IC_CH_PER_CYCLE - 8'd1);
                 end
-                
-                READ_DONE: begin
-                    wgt_valid_reg <= 1'b1;
-                    if (wgt_ready) begin
-                        read_state_reg <= READ_IDLE;
-                    end
-                end
-                
-                default: read_state_reg <= READ_IDLE;
-            endcase
+            end
         end
     end
     
-    // 组合逻辑：根据状态读取 RAM 并重组为 wgt2 格式
-    // 在 READ_ACTIVE 或 READ_DONE 状态下保持输出稳定
-    always_comb begin
-        // 初始化局部变量
-        logic [2:0]  wgt_slices_local;
-        logic [7:0]  OC_CH_PER_CYCLE_local;
-        logic [15:0] phys_oc, phys_ic;
-        logic [ADDR_W-1:0] addr;
-        logic [MAX_WGT_BITS-1:0] wgt_val;
-        logic [7:0] oc_lane;
-        
-        // 默认值
-        wgt_slices_local = reg_wgt_bits[4:1];
-        OC_CH_PER_CYCLE_local = OC2_LANES / wgt_slices_local;
-        phys_oc = '0;
-        phys_ic = '0;
-        addr = '0;
-        wgt_val = '0;
-        oc_lane = '0;
-        
-        // 默认清零
-        for (int oc = 0; oc < OC2_LANES; oc++) begin
-            for (int kh_i = 0; kh_i < KH; kh_i++) begin
-                for (int kw_i = 0; kw_i < KW; kw_i++) begin
-                    for (int ic = 0; ic < IC2_LANES; ic++) begin
-                        wgt2_reg[oc][kh_i][kw_i][ic] = '0;
-                    end
-                end
+    // S2: 输出寄存器
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            wgt_valid_reg <= 1'b0;
+        end else begin
+            if (s2_load) begin
+                wgt_valid_reg <= s1_valid;
             end
         end
-        
-        // 只在 READ_ACTIVE 或 READ_DONE 状态计算输出
-        if (read_state_reg == READ_ACTIVE || read_state_reg == READ_DONE) begin
-            
-            // 遍历所有 slice group
-            for (int g = 0; g < 8; g++) begin
-                if (g < wgt_slices_local) begin
-                    // 遍历当前 group 内的输出通道
-                    for (int p = 0; p < 16; p++) begin
-                        if (p < OC_CH_PER_CYCLE_local) begin
-                            phys_oc = read_oc_base + p[15:0];
-                            oc_lane = g[7:0] * OC_CH_PER_CYCLE_local + p[7:0];
-                            
-                            // 遍历输入通道 (固定 IC2_LANES=16)
-                            for (int i = 0; i < IC2_LANES; i++) begin
-                                phys_ic = read_ic_base + i[15:0];
-                                
-                                // 遍历 kernel 位置
-                                for (int kh_i = 0; kh_i < KH; kh_i++) begin
-                                    for (int kw_i = 0; kw_i < KW; kw_i++) begin
-                                        // 边界检查
-                                        if (phys_oc < reg_OC && phys_ic < reg_IC) begin
-                                            addr = calc_wgt_addr(phys_oc, phys_ic, 
-                                                                kh_i[1:0], kw_i[1:0]);
-                                            wgt_val = wgt_ram[addr];
-                                            
-                                            // 提取对应 slice 的 2-bit
-                                            wgt2_reg[oc_lane][kh_i][kw_i][i] = get_slice(wgt_val, g[2:0]);
-                                        end else begin
-                                            wgt2_reg[oc_lane][kh_i][kw_i][i] = '0;
-                                        end
-                                    end
-                                end
+    end
+    
+    generate
+        genvar lane;
+        for (lane = 0; lane < OC2_LANES; lane++) begin : gen_bank_rd
+            logic [BANK_W-1:0] rd_word;
+    
+            for (genvar rk = 0; rk < KH*KW; rk++) begin : gen_rd_k
+                assign rd_word[rk*WORD_W +: WORD_W] = wgt_bank[rd_buf][lane][rk][s1_addr];
+            end
+    
+            always_ff @(posedge clk) begin
+                if (s2_load && s1_valid) begin
+                    for (int kh_i = 0; kh_i < KH; kh_i++) begin
+                        for (int kw_i = 0; kw_i < KW; kw_i++) begin
+                            for (int ic = 0; ic < IC2_LANES; ic++) begin
+                                // ic lane = s * IC_CH_PER_CYCLE + ch 取字内通道 ic_off + ch。
+                                // 配置检查保证 IC / OC 是每组通道数的整数倍, 块内没有越界通道;
+                                // 码 00 解码为 -3 而非 0, 不能用作屏蔽值
+                                wgt2_reg[lane][kh_i][kw_i][ic] <=
+                                    rd_word[((kh_i * KW + kw_i) * IC2_LANES +
+                                             int'(s1_ic_off + (4'(ic) & s1_ch_mask))) * 2 +: 2];
                             end
                         end
                     end
                 end
             end
         end
-    end
+    endgenerate
     
     // 输出连接
-    assign req_ready = (read_state_reg == READ_IDLE);
     assign wgt_valid = wgt_valid_reg;
     
     // 输出 wgt2
@@ -364,17 +523,21 @@ module weight_buffer #(
     `ifdef SIMULATION
         always @(posedge clk) begin
             if (cfg_valid && cfg_ready) begin
-                if (!(cfg_wgt_bits == 2 || cfg_wgt_bits == 4 || 
+                if (!(cfg_wgt_bits == 2 || cfg_wgt_bits == 4 ||
                       cfg_wgt_bits == 8 || cfg_wgt_bits == 16)) begin
                     $error("[weight_buffer] Illegal cfg_wgt_bits: %d", cfg_wgt_bits);
                 end
+                if (!(cfg_act_bits == 2 || cfg_act_bits == 4 ||
+                      cfg_act_bits == 8 || cfg_act_bits == 16)) begin
+                    $error("[weight_buffer] Illegal cfg_act_bits: %d", cfg_act_bits);
+                end
             end
         end
-        
+    
         always @(posedge clk) begin
             if (wgt_load_done) begin
-                $display("[weight_buffer] Load done. Elements loaded: %0d, expected: %0d",
-                         load_element_cnt, total_elements);
+                $display("[weight_buffer] Load done. Elements loaded: %0d",
+                         load_element_cnt);
             end
         end
     `endif
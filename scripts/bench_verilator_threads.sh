@@ -0,0 +1,53 @@
+#!/usr/bin/env bash
+#=============================================================================
+# bench_verilator_threads.sh - Measure tb_top.cpp run time vs model threads
+#
+# Usage: scripts/bench_verilator_threads.sh [RUNS] [THREADS...]
+#   RUNS     runs per thread count, best time kept (default 3)
+#   THREADS  thread counts to build and measure (default 1 2 4 8)
+#
+# Prints a markdown table (threads, build time, best run time, speedup vs
+# the first entry) for VERIFICATION_REPORT.md. Runs are pinned to the
+# first N CPUs with taskset when available so counts don't share cores.
+#=============================================================================
+set -euo pipefail
+
+RUNS=${1:-3}
+shift || true
+COUNTS=("$@")
+if [ ${#COUNTS[@]} -eq 0 ]; then
+    COUNTS=(1 2 4 8)
+fi
+
+now() { date +%s.%N; }
+
+declare -A BUILD RUN
+for n in "${COUNTS[@]}"; do
+    t0=$(now)
+    TRACE=none scripts/build_verilator.sh "$n" > "build_t${n}.log" 2>&1
+    BUILD[$n]=$(echo "$(now) - $t0" | bc)
+
+    PIN=()
+    if command -v taskset > /dev/null; then
+        PIN=(taskset -c "0-$((n - 1))")
+    fi
+
+    best=""
+    for ((r = 0; r < RUNS; r++)); do
+        t0=$(now)
+        "${PIN[@]}" "obj_dir_t${n}/Vconv3x3_accel_top" > "run_t${n}.log"
+        t=$(echo "$(now) - $t0" | bc)
+        if [ -z "$best" ] || [ "$(echo "$t < $best" | bc)" -eq 1 ]; then
+            best=$t
+        fi
+    done
+    RUN[$n]=$best
+done
+
+base=${RUN[${COUNTS[0]}]}
+echo "| threads | build (s) | run (s) | speedup |"
+echo "|--------:|----------:|--------:|--------:|"
+for n in "${COUNTS[@]}"; do
+    printf "| %7s | %9.1f | %7.2f | %6.2fx |\n" "$n" "${BUILD[$n]}" "${RUN[$n]}" \
+        "$(echo "$base / ${RUN[$n]}" | bc -l)"
+done
@@ -0,0 +1,40 @@
+#!/usr/bin/env bash
+#=============================================================================
+# build_verilator.sh - Build the tb_top.cpp simulation of conv3x3_accel_top
+#
+# Usage: [TRACE=fst|vcd|none] scripts/build_verilator.sh [THREADS] [extra verilator args...]
+#   THREADS  model threads (verilator --threads), default 1
+#   TRACE    waveform support compiled in, default fst; dumping itself is
+#            still off until the simulation is run with --trace
+#   OBJ_DIR  output directory, default obj_dir_t<THREADS>
+#
+# Each thread count gets its own obj_dir_t<N> so builds can be compared
+# side by side. Run from the repository root.
+#=============================================================================
+set -euo pipefail
+
+THREADS=${1:-1}
+shift || true
+OBJ_DIR=${OBJ_DIR:-obj_dir_t${THREADS}}
+
+TRACE=${TRACE:-fst}
+case "$TRACE" in
+    fst)  TRACE_ARGS=(--trace-fst) ;;
+    vcd)  TRACE_ARGS=(--trace) ;;
+    none) TRACE_ARGS=() ;;
+    *)    echo "TRACE must be fst, vcd or none" >&2; exit 1 ;;
+esac
+
+THREAD_ARGS=()
+if [ "$THREADS" -gt 1 ]; then
+    THREAD_ARGS=(--threads "$THREADS")
+fi
+
+verilator --cc --exe --build -j 0 -O3 -Wno-fatal \
+  --top-module conv3x3_accel_top \
+  "${TRACE_ARGS[@]}" "${THREAD_ARGS[@]}" "$@" \
+  rtl/*.sv tb/tb_top.cpp tb/conv3x3_golden*.cpp \
+  -CFLAGS "-O2 -std=c++17" -LDFLAGS -pthread \
+  -Mdir "$OBJ_DIR"
+
+echo "Built $OBJ_DIR/Vconv3x3_accel_top (threads=$THREADS, trace=$TRACE)"
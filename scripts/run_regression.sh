@@ -0,0 +1,66 @@
+#!/usr/bin/env bash
+#=============================================================================
+# run_regression.sh - Build and run the Verilator regression
+#
+# Usage: scripts/run_regression.sh
+#
+# Runs tb_weight_buffer.sv and tb_conv3x3_accel.sv (verilator --binary),
+# then tb_top.cpp built with WGT_PINGPONG=1 and =0 over the default layer
+# and the --pad, --tile-cols, --batch and --out-bits/--relu variants.
+# Each run's log goes to reg_<name>.log; prints one PASS/FAIL line per run
+# and exits non-zero if any failed. Run from the repository root.
+#=============================================================================
+set -uo pipefail
+
+FAILED=0
+
+report() {
+    if [ "$2" -eq 0 ]; then
+        echo "PASS  $1"
+    else
+        echo "FAIL  $1  (see reg_$1.log)"
+        FAILED=1
+    fi
+}
+
+# SV testbenches end with $finish either way, so pass/fail comes from the
+# summary line rather than the exit status
+run_sv() {
+    local name=$1 top=$2 pass=$3
+    shift 3
+    verilator --binary --timing -Wno-fatal -Mdir "obj_dir_$name" --top-module "$top" "$@" \
+        > "reg_$name.log" 2>&1 &&
+        "obj_dir_$name/V$top" >> "reg_$name.log" 2>&1 &&
+        grep -q "$pass" "reg_$name.log"
+    report "$name" $?
+}
+
+run_sv wbuf tb_weight_buffer "ALL WEIGHT BUFFER TESTS PASSED" \
+    tb/tb_weight_buffer.sv rtl/weight_buffer.sv rtl/conv_core_lowbit.sv rtl/muladd2_lut.sv
+run_sv accel tb_conv3x3_accel "ALL TESTS PASSED" \
+    tb/tb_conv3x3_accel.sv rtl/*.sv
+
+VARIANTS=(
+    "default:"
+    "pad:--pad"
+    "tile:--tile-cols=4"
+    "wide:--width=600 --tile-cols=256"
+    "batch:--batch=2"
+    "outbits:--out-bits=8 --relu"
+)
+
+for pp in 1 0; do
+    if ! OBJ_DIR=obj_dir_pp${pp} TRACE=none scripts/build_verilator.sh 1 -GWGT_PINGPONG="$pp" \
+            > "reg_build_pp${pp}.log" 2>&1; then
+        report "build_pp${pp}" 1
+        continue
+    fi
+    for v in "${VARIANTS[@]}"; do
+        name=top_pp${pp}_${v%%:*}
+        # shellcheck disable=SC2086
+        "obj_dir_pp${pp}/Vconv3x3_accel_top" ${v#*:} > "reg_$name.log" 2>&1
+        report "$name" $?
+    done
+done
+
+exit $FAILED
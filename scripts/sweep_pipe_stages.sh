@@ -0,0 +1,55 @@
+#!/usr/bin/env bash
+#=============================================================================
+# sweep_pipe_stages.sh - Compare conv_core PIPE_STAGES builds on one stimulus
+#
+# Usage: scripts/sweep_pipe_stages.sh [STAGES...] [-- tb_top args...]
+#   STAGES        PIPE_STAGES values to build and run (default 1 2 3 4)
+#   tb_top args   passed to every run, e.g. -- --pad --batch=2
+#
+# The first build saves its random stimulus to sweep_pipe.tns and every
+# build then replays that file, so all rows see the same layer. Prints a
+# markdown table (result, perf_cyc_total, perf_core_fire, perf_core_burst)
+# for VERIFICATION_REPORT.md; Fmax still needs synthesis. Run from the
+# repository root.
+#=============================================================================
+set -euo pipefail
+
+STAGES=()
+while [ $# -gt 0 ] && [ "$1" != "--" ]; do
+    STAGES+=("$1")
+    shift
+done
+[ $# -gt 0 ] && shift
+if [ ${#STAGES[@]} -eq 0 ]; then
+    STAGES=(1 2 3 4)
+fi
+
+STIM=sweep_pipe.tns
+rm -f "$STIM"
+
+declare -A RESULT TOTAL FIRE BURST
+for n in "${STAGES[@]}"; do
+    OBJ_DIR=obj_dir_p${n} TRACE=none scripts/build_verilator.sh 1 -GPIPE_STAGES="$n" \
+        > "build_p${n}.log" 2>&1
+
+    if [ -f "$STIM" ]; then
+        STIM_ARG=--stimulus="$STIM"
+    else
+        STIM_ARG=--save-stimulus="$STIM"
+    fi
+    if "obj_dir_p${n}/Vconv3x3_accel_top" "$STIM_ARG" "$@" > "run_p${n}.log"; then
+        RESULT[$n]=PASS
+    else
+        RESULT[$n]=FAIL
+    fi
+    TOTAL[$n]=$(awk '/total cycles/ { print $3; exit }' "run_p${n}.log")
+    FIRE[$n]=$(awk '/core fire / && !/burst/ { print $3; exit }' "run_p${n}.log")
+    BURST[$n]=$(awk '/core fire burst/ { print $4; exit }' "run_p${n}.log")
+done
+
+echo "| PIPE_STAGES | result | perf_cyc_total | perf_core_fire | perf_core_burst |"
+echo "|:-----------:|:------:|---------------:|---------------:|----------------:|"
+for n in "${STAGES[@]}"; do
+    printf "| %11s | %6s | %14s | %14s | %15s |\n" "$n" "${RESULT[$n]}" \
+        "${TOTAL[$n]:--}" "${FIRE[$n]:--}" "${BURST[$n]:--}"
+done
@@ -0,0 +1,308 @@
+//=============================================================================
+// conv3x3_golden.cpp - Bit-accurate C++ reference model for conv3x3_accel_top
+//=============================================================================
+
+#include "conv3x3_golden.h"
+#include <algorithm>
+#include <cstring>
+
+namespace golden {
+
+//-----------------------------------------------------------------------------
+// LayerConfig
+//-----------------------------------------------------------------------------
+static bool legal_bits(int bits) {
+    return bits == 2 || bits == 4 || bits == 8 || bits == 16;
+}
+
+const char* LayerConfig::validate(int max_cols) const {
+    // Widest run: a whole row, or a tile of at most max(max_cols, KW) columns
+    const int run_W = max_cols > 0 && max_cols < W ? std::max(max_cols, KW) : W;
+    if (stride != 0 && stride != 1)      return "stride";
+    if (pad != 0 && pad != 1)            return "pad";
+    if (batch < 1 || batch > 255)        return "batch";
+    if (!legal_bits(act_bits))           return "act_bits";
+    if (!legal_bits(wgt_bits))           return "wgt_bits";
+    if (out_bits != 32 && !legal_bits(out_bits)) return "out_bits";
+    if (pad_use_code && legal_bits(act_bits) && (pad_code >> act_bits) != 0) return "pad_code";
+    if (IC <= 0 || IC % ic_ch_per_cycle() != 0) return "IC alignment";
+    if (OC <= 0 || OC % oc_ch_per_cycle() != 0) return "OC alignment";
+    if (W > 0xFFFF || run_W > 256 || H > 256 || IC > 256 || OC > 256) return "size exceed";
+    if (OH() == 0 || OW() == 0)          return "empty output";
+    return nullptr;
+}
+
+//-----------------------------------------------------------------------------
+// ColumnTile
+//-----------------------------------------------------------------------------
+// Same arithmetic as calc_tile_ox0 / calc_tile_ow in conv3x3_accel_top, in
+// padded coordinates (image column x at x + pad)
+int ColumnTile::ox0(const LayerConfig& c) const {
+    const int xs = x0 == 0 ? 0 : x0 + c.pad;
+    return (xs + c.stride_step() - 1) / c.stride_step();
+}
+
+int ColumnTile::OW(const LayerConfig& c) const {
+    const int xe = x0 + cols(c) >= c.W ? c.W + 2 * c.pad : x0 + cols(c) + c.pad;
+    if (xe < KW)
+        return 0;
+    const int hi = (xe - KW) / c.stride_step();
+    return hi >= ox0(c) ? hi - ox0(c) + 1 : 0;
+}
+
+std::vector<ColumnTile> column_tiles(const LayerConfig& c, int max_cols) {
+    if (max_cols >= c.W)
+        return {ColumnTile{}};
+    if (max_cols < KW)
+        max_cols = KW;
+    // Each tile starts at the first input column of the next output column
+    // and produces at least one output column
+    std::vector<ColumnTile> tiles;
+    for (int ox = 0; ox < c.OW(); ) {
+        ColumnTile t;
+        t.x0 = std::max(0, ox * c.stride_step() - c.pad);
+        t.W  = std::min(c.W, t.x0 + max_cols) - t.x0;
+        tiles.push_back(t);
+        ox = t.ox0(c) + t.OW(c);
+    }
+    return tiles;
+}
+
+void extract_tile(const LayerConfig& c, const ColumnTile& t, const uint8_t* act,
+                  uint8_t* tile_stream) {
+    const int cols = t.cols(c);
+    memset(tile_stream, 0, t.act_beats(c) * BUS_BYTES);
+    for (int y = 0; y < c.H; y++)
+        for (int x = 0; x < cols; x++)
+            for (int ic = 0; ic < c.IC; ic++)
+                stream_put(tile_stream, (size_t(y) * cols + x) * c.IC + ic, c.act_bits,
+                           stream_get(act, (size_t(y) * c.W + t.x0 + x) * c.IC + ic, c.act_bits));
+}
+
+//-----------------------------------------------------------------------------
+// Element helpers
+//-----------------------------------------------------------------------------
+int decode2(uint32_t code) {
+    static const int lut[4] = {-3, -1, 1, 3};
+    return lut[code & 0x3];
+}
+
+int32_t reconstruct(uint32_t code, int bits) {
+    int32_t val = 0;
+    for (int s = 0; s < bits / 2; s++)
+        val += decode2(code >> (2 * s)) * (1 << (2 * s));
+    return val;
+}
+
+uint32_t muladd2_lut(uint32_t a0, uint32_t w0, uint32_t a1, uint32_t w1) {
+    int pair_sum = decode2(a0) * decode2(w0) + decode2(a1) * decode2(w1);
+    return uint32_t(pair_sum + 18) >> 1;
+}
+
+uint32_t stream_get(const uint8_t* stream, size_t idx, int bits) {
+    size_t bit = idx * bits;
+    const uint8_t* p = stream + bit / 8;
+    switch (bits) {
+        case 2:  return (p[0] >> (bit & 7)) & 0x3;
+        case 4:  return (p[0] >> (bit & 7)) & 0xF;
+        case 8:  return p[0];
+        case 16: return uint32_t(p[0]) | (uint32_t(p[1]) << 8);
+        default: return 0;
+    }
+}
+
+void stream_put(uint8_t* stream, size_t idx, int bits, uint32_t code) {
+    size_t bit = idx * bits;
+    uint8_t* p = stream + bit / 8;
+    switch (bits) {
+        case 2:
+        case 4: {
+            uint8_t mask = uint8_t(((1u << bits) - 1) << (bit & 7));
+            p[0] = uint8_t((p[0] & ~mask) | ((code << (bit & 7)) & mask));
+            break;
+        }
+        case 8:  p[0] = uint8_t(code); break;
+        case 16: p[0] = uint8_t(code); p[1] = uint8_t(code >> 8); break;
+        default: break;
+    }
+}
+
+//-----------------------------------------------------------------------------
+// ConvGolden
+//-----------------------------------------------------------------------------
+ConvGolden::ConvGolden(const LayerConfig& cfg, const uint8_t* act_stream,
+                       const uint8_t* wgt_stream, Kernel kernel)
+    : cfg_(cfg), act_(act_stream), wgt_(wgt_stream), kernel_(kernel) {
+    if (cfg_.act_bits != 2 || cfg_.wgt_bits != 2)
+        kernel_ = Kernel::Reference;
+    if (!packed_path())
+        return;
+
+    // Re-lay weights once so that the 9 taps of one oc are contiguous, in the
+    // same order as the gathered activation window.
+    tap_bytes_ = size_t(cfg_.IC) / 4;
+    win_bytes_ = (KH * KW * tap_bytes_ + 63) / 64 * 64;
+    wgt_rows_.assign(size_t(cfg_.OC) * win_bytes_, PAD_WGT);
+    for (int oc = 0; oc < cfg_.OC; oc++)
+        for (int t = 0; t < KH * KW; t++)
+            memcpy(&wgt_rows_[oc * win_bytes_ + t * tap_bytes_],
+                   wgt_ + (size_t(t) * cfg_.OC + oc) * tap_bytes_, tap_bytes_);
+}
+
+bool ConvGolden::packed_window(int oy, int ox) const {
+    if (!packed_path())
+        return false;
+    const int iy0 = oy * cfg_.stride_step() - cfg_.pad;
+    const int ix0 = ox * cfg_.stride_step() - cfg_.pad;
+    return cfg_.pad_use_code ||
+           (in_image(iy0, ix0) && in_image(iy0 + KH - 1, ix0 + KW - 1));
+}
+
+void ConvGolden::gather_window(int oy, int ox, uint8_t* win) const {
+    // The three kw taps of a window row are adjacent pixels, i.e. one
+    // contiguous run of 3 * IC / 4 bytes for either stride. Border taps of
+    // a padded layer are filled with the pad code.
+    const int iy0 = oy * cfg_.stride_step() - cfg_.pad;
+    const int ix0 = ox * cfg_.stride_step() - cfg_.pad;
+    const uint8_t pad_byte = uint8_t((cfg_.pad_code & 3) * 0x55);
+    for (int kh = 0; kh < KH; kh++) {
+        uint8_t* row = win + kh * KW * tap_bytes_;
+        if (in_image(iy0 + kh, ix0) && in_image(iy0 + kh, ix0 + KW - 1)) {
+            memcpy(row, act_ + ((size_t(iy0 + kh) * cfg_.W + ix0) * cfg_.IC) / 4,
+                   KW * tap_bytes_);
+            continue;
+        }
+        for (int kw = 0; kw < KW; kw++) {
+            if (in_image(iy0 + kh, ix0 + kw))
+                memcpy(row + kw * tap_bytes_,
+                       act_ + ((size_t(iy0 + kh) * cfg_.W + ix0 + kw) * cfg_.IC) / 4,
+                       tap_bytes_);
+            else
+                memset(row + kw * tap_bytes_, pad_byte, tap_bytes_);
+        }
+    }
+    memset(win + KH * KW * tap_bytes_, PAD_ACT, win_bytes_ - KH * KW * tap_bytes_);
+}
+
+int32_t ConvGolden::packed_output(const uint8_t* win, int oc) const {
+    // sum(lut) - 9 * n_pairs over all ic groups; padding pairs add exactly 9
+    uint64_t sum_u = lut_dot2(kernel_, win, &wgt_rows_[oc * win_bytes_], win_bytes_);
+    return int32_t(uint32_t(sum_u - 9 * 2 * uint64_t(win_bytes_)));
+}
+
+void ConvGolden::core_partial(int oy, int ox, int oc_grp, int ic_grp,
+                              int32_t* partial) const {
+    const int act_slices = cfg_.act_slices();
+    const int wgt_slices = cfg_.wgt_slices();
+    const int icpc       = cfg_.ic_ch_per_cycle();
+    const int ocpc       = cfg_.oc_ch_per_cycle();
+    const int iy0        = oy * cfg_.stride_step() - cfg_.pad;
+    const int ix0        = ox * cfg_.stride_step() - cfg_.pad;
+    const int ic_base    = ic_grp * icpc;
+
+    // Lane mapping (slice-major, as feature_line_buffer / weight_buffer):
+    //   ic lane = act_slice * icpc + ch
+    //   oc lane = wgt_slice * ocpc + p
+    for (int p = 0; p < ocpc; p++) {
+        const int oc = oc_grp * ocpc + p;
+        uint32_t final_result = 0;
+
+        for (int g = 0; g < wgt_slices; g++) {
+            uint32_t act_merge = 0;
+
+            for (int s = 0; s < act_slices; s++) {
+                // Unsigned reduction of LUT outputs for this slice
+                uint32_t sum_u = 0;
+                for (int kh = 0; kh < KH; kh++) {
+                    for (int kw = 0; kw < KW; kw++) {
+                        // Border tap: win_mask low forces the neutral 9
+                        // per pair, otherwise it reads as the pad code
+                        const bool inside = in_image(iy0 + kh, ix0 + kw);
+                        if (!inside && !cfg_.pad_use_code) {
+                            sum_u += 9 * uint32_t(icpc / 2);
+                            continue;
+                        }
+                        for (int ch = 0; ch < icpc; ch += 2) {
+                            const int ic = ic_base + ch;
+                            uint32_t a0 = (inside ? act_code(iy0 + kh, ix0 + kw, ic)
+                                                  : cfg_.pad_code) >> (2 * s);
+                            uint32_t a1 = (inside ? act_code(iy0 + kh, ix0 + kw, ic + 1)
+                                                  : cfg_.pad_code) >> (2 * s);
+                            uint32_t w0 = wgt_code(kh, kw, oc, ic)     >> (2 * g);
+                            uint32_t w1 = wgt_code(kh, kw, oc, ic + 1) >> (2 * g);
+                            sum_u += muladd2_lut(a0 & 3, w0 & 3, a1 & 3, w1 & 3);
+                        }
+                    }
+                }
+                // Act slice merge of the unsigned sums (ACC_W wraparound)
+                act_merge += sum_u << (2 * s);
+            }
+            final_result += act_merge << (2 * g);
+        }
+        partial[p] = int32_t(final_result);
+    }
+}
+
+uint32_t ConvGolden::lut_offset() const {
+    const uint32_t n_pairs = uint32_t(KH * KW * cfg_.ic_ch_per_cycle()) >> 1;
+    uint32_t geo_a = 0, geo_w = 0;
+    for (int s = 0; s < cfg_.act_slices(); s++)
+        geo_a += 1u << (2 * s);
+    for (int g = 0; g < cfg_.wgt_slices(); g++)
+        geo_w += 1u << (2 * g);
+    return n_pairs * 9 * geo_a * geo_w;
+}
+
+void ConvGolden::compute_oc_group(int oy, int ox, int oc_grp, int32_t* out) const {
+    const int ocpc = cfg_.oc_ch_per_cycle();
+    if (packed_window(oy, ox)) {
+        alignas(64) uint8_t win[KH * KW * 64 + 64];
+        gather_window(oy, ox, win);
+        for (int p = 0; p < ocpc; p++)
+            out[p] = packed_output(win, oc_grp * ocpc + p);
+        return;
+    }
+
+    // The accumulator starts at -num_ic_grp * lut_offset, as r_acc_bias
+    const uint32_t bias = 0u - uint32_t(cfg_.num_ic_grp()) * lut_offset();
+    int32_t partial[OC2_LANES];
+    uint32_t acc[OC2_LANES];
+    for (int p = 0; p < ocpc; p++)
+        acc[p] = bias;
+
+    for (int ic_grp = 0; ic_grp < cfg_.num_ic_grp(); ic_grp++) {
+        core_partial(oy, ox, oc_grp, ic_grp, partial);
+        for (int p = 0; p < ocpc; p++)
+            acc[p] += uint32_t(partial[p]);
+    }
+    for (int p = 0; p < ocpc; p++)
+        out[p] = int32_t(acc[p]);
+}
+
+void ConvGolden::compute_pixel(int oy, int ox, int32_t* out) const {
+    const int ocpc = cfg_.oc_ch_per_cycle();
+    if (packed_window(oy, ox)) {
+        alignas(64) uint8_t win[KH * KW * 64 + 64];
+        gather_window(oy, ox, win);
+        for (int oc = 0; oc < cfg_.OC; oc++)
+            out[oc] = packed_output(win, oc);
+        return;
+    }
+    for (int oc_grp = 0; oc_grp < cfg_.num_oc_grp(); oc_grp++)
+        compute_oc_group(oy, ox, oc_grp, out + oc_grp * ocpc);
+}
+
+void ConvGolden::compute(int32_t* out) const {
+    const int OW = cfg_.OW();
+    for (int oy = 0; oy < cfg_.OH(); oy++)
+        for (int ox = 0; ox < OW; ox++)
+            compute_pixel(oy, ox, out + (size_t(oy) * OW + ox) * cfg_.OC);
+}
+
+std::vector<int32_t> ConvGolden::compute() const {
+    std::vector<int32_t> out(cfg_.out_elements());
+    compute(out.data());
+    return out;
+}
+
+} // namespace golden
@@ -0,0 +1,464 @@
+//=============================================================================
+// conv3x3_golden.h - Bit-accurate C++ reference model for conv3x3_accel_top
+//
+// Reproduces the accelerator datapath exactly:
+//   - decode2 of every 2-bit slice (00->-3, 01->-1, 10->+1, 11->+3)
+//   - muladd2_lut pair identity: (p0 + p1 + 18) >> 1, the offset of all
+//     slices folded into one constant subtracted at the accumulator
+//   - slice recombination  sum_s << (2*s)  for activation and weight slices
+//   - ACC_W (32-bit) two's complement wraparound in core and accumulator
+//   - output stream order (oy, ox, oc) with oc innermost
+//   - same padding: border taps masked (LUT pairs at the neutral 9) or
+//     set to the configured pad code, as feature_line_buffer
+//
+// 2b x 2b layers run on a vectorized kernel (AVX2 / AVX-512BW, selected at
+// runtime, scalar fallback) that works directly on the packed stream bytes;
+// other modes use the slice-level reference path.
+//
+// Input tensors are the packed bus streams exactly as driven on
+// act_in_data / wgt_in_data: element i occupies bits [i*bits +: bits],
+// little-endian across BUS_W beats.
+//   act element index: (y * W + x) * IC + ic
+//   wgt element index: ((kh * 3 + kw) * OC + oc) * IC + ic
+//=============================================================================
+
+#ifndef CONV3X3_GOLDEN_H
+#define CONV3X3_GOLDEN_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace golden {
+
+constexpr int KH        = 3;
+constexpr int KW        = 3;
+constexpr int IC2_LANES = 16;
+constexpr int OC2_LANES = 16;
+constexpr int BUS_W     = 128;
+constexpr int BUS_BYTES = BUS_W / 8;
+
+//-----------------------------------------------------------------------------
+// Layer configuration (mirrors the cfg_* ports of conv3x3_accel_top)
+//-----------------------------------------------------------------------------
+struct LayerConfig {
+    int W = 0, H = 0, IC = 0, OC = 0;
+    int stride   = 0;   // cfg_stride: 0 = stride 1, 1 = stride 2
+    int act_bits = 2;   // 2, 4, 8, 16
+    int wgt_bits = 2;   // 2, 4, 8, 16
+    int out_bits = 32;  // 32 = raw ACC_W (cfg_mode_raw_out), else cfg_out_bits 2/4/8/16
+    bool relu    = false;  // cfg_relu; with out_bits = 32 negative sums read 0
+    int pad      = 0;   // cfg_pad: 0 = valid, 1 = same (one-pixel border)
+    bool     pad_use_code = false;  // cfg_pad_use_code: border taps zero / pad_code
+    uint32_t pad_code     = 0;      // cfg_pad_code (act_bits wide)
+    int batch    = 1;   // cfg_batch: images per weight load (1..255)
+
+    int stride_step() const { return stride ? 2 : 1; }
+    int OH() const { return H + 2 * pad < KH ? 0 : (H + 2 * pad - KH) / stride_step() + 1; }
+    int OW() const { return W + 2 * pad < KW ? 0 : (W + 2 * pad - KW) / stride_step() + 1; }
+
+    int act_slices() const { return act_bits / 2; }
+    int wgt_slices() const { return wgt_bits / 2; }
+    int ic_ch_per_cycle() const { return IC2_LANES / act_slices(); }
+    int oc_ch_per_cycle() const { return OC2_LANES / wgt_slices(); }
+    int num_ic_grp() const { return IC / ic_ch_per_cycle(); }
+    int num_oc_grp() const { return OC / oc_ch_per_cycle(); }
+
+    // Element counts and beats are per image; a batch streams batch
+    // activation tensors (each starting on a fresh beat) and produces
+    // batch output tensors, each closed by out_last
+    size_t act_elements() const { return size_t(H) * W * IC; }
+    size_t wgt_elements() const { return size_t(KH) * KW * OC * IC; }
+    size_t out_elements() const { return size_t(OH()) * OW() * OC; }
+
+    // Packed stream sizes, rounded up to whole BUS_W beats
+    size_t act_beats() const { return (act_elements() * act_bits + BUS_W - 1) / BUS_W; }
+    size_t wgt_beats() const { return (wgt_elements() * wgt_bits + BUS_W - 1) / BUS_W; }
+    size_t out_beats() const { return (out_elements() * out_bits + BUS_W - 1) / BUS_W; }
+
+    // Same legality rules as the top-level constraint checker; returns
+    // nullptr when the configuration is usable, otherwise a reason string.
+    // With max_cols > 0 the layer runs as column_tiles(*this, max_cols), so
+    // the width limit applies to the tile, not to W (check 7 of the top).
+    const char* validate(int max_cols = 0) const;
+};
+
+//-----------------------------------------------------------------------------
+// Column tile (mirrors cfg_tile_x0 / cfg_tile_W): only input columns
+// [x0, x0 + W) of each row are streamed, W = 0 streams whole rows. The tile
+// produces the output columns whose windows lie inside it, [ox0, ox0 + OW);
+// a tile starting at column 0 / ending at column cfg.W also covers the left
+// / right border of a padded layer. Its output stream is that
+// OH x OW x OC block in (oy, ox, oc) order; the host places it at column
+// ox0 of the layer output.
+//-----------------------------------------------------------------------------
+struct ColumnTile {
+    int x0 = 0, W = 0;
+
+    int    cols(const LayerConfig& c) const { return W ? W : c.W; }
+    int    ox0(const LayerConfig& c) const;
+    int    OW(const LayerConfig& c) const;
+    size_t act_elements(const LayerConfig& c) const { return size_t(c.H) * cols(c) * c.IC; }
+    size_t out_elements(const LayerConfig& c) const { return size_t(c.OH()) * OW(c) * c.OC; }
+    size_t act_beats(const LayerConfig& c) const {
+        return (act_elements(c) * c.act_bits + BUS_W - 1) / BUS_W;
+    }
+    size_t out_beats(const LayerConfig& c) const {
+        return (out_elements(c) * c.out_bits + BUS_W - 1) / BUS_W;
+    }
+};
+
+// Tiles of at most max_cols (>= KW) input columns that cover every output
+// column exactly once, left to right. Neighbouring tiles overlap by the
+// window halo (2 columns at stride 1).
+std::vector<ColumnTile> column_tiles(const LayerConfig& c, int max_cols);
+
+// Copy the tile's columns out of a whole-layer activation stream into a
+// tile stream of t.act_beats(c) beats
+void extract_tile(const LayerConfig& c, const ColumnTile& t, const uint8_t* act,
+                  uint8_t* tile_stream);
+
+//-----------------------------------------------------------------------------
+// Element level helpers
+//-----------------------------------------------------------------------------
+int decode2(uint32_t code);
+
+// valN = sum_s decode2(slice_s) << (2*s)
+int32_t reconstruct(uint32_t code, int bits);
+
+// muladd2_lut.sv: (decode2(a0)*decode2(w0) + decode2(a1)*decode2(w1) + 18) >> 1
+uint32_t muladd2_lut(uint32_t a0, uint32_t w0, uint32_t a1, uint32_t w1);
+
+// Read / write element idx of a packed stream
+uint32_t stream_get(const uint8_t* stream, size_t idx, int bits);
+void     stream_put(uint8_t* stream, size_t idx, int bits, uint32_t code);
+
+//-----------------------------------------------------------------------------
+// Bulk stream packing (conv3x3_golden_pack.cpp)
+//
+// Same layout as stream_get / stream_put, for whole tensors at once. Codes
+// for 2/4/8-bit elements are one per byte (only the low bits are used);
+// 16-bit codes use the uint16_t overloads. The stream must have room for
+// (n * bits + 7) / 8 bytes; bits past the last element in the final byte
+// are written as zero.
+//-----------------------------------------------------------------------------
+enum class PackKernel { Scalar, BMI2, AVX2 };
+
+PackKernel  detect_pack_kernel();
+const char* pack_kernel_name(PackKernel k);
+
+void pack_codes(const uint8_t* codes, size_t n, int bits, uint8_t* stream,
+                PackKernel k = detect_pack_kernel());
+void unpack_codes(const uint8_t* stream, size_t n, int bits, uint8_t* codes,
+                  PackKernel k = detect_pack_kernel());
+void pack_codes(const uint16_t* codes, size_t n, uint8_t* stream);
+void unpack_codes(const uint8_t* stream, size_t n, uint16_t* codes);
+
+//-----------------------------------------------------------------------------
+// Output post-ops (conv3x3_golden_post.cpp)
+//
+// other_ops_stub.sv per-OC bias / folded BN / ReLU / requantization of an
+// accumulator value to a bits-wide activation code (bits = 2, 4, 8, 16):
+//   v    = acc + bias                               (33 bits, no wraparound)
+//   t    = (v * scale + 2^(shift-1)) >> shift       (no rounding term if shift = 0)
+//   t    = relu ? max(t, 0) : t
+//   code = clamp((t + 2^bits - 1) >> 1, 0, 2^bits - 1)
+// reconstruct(code, bits) is t snapped down to the odd value grid, so the
+// codes feed the next layer's act stream unchanged.
+//-----------------------------------------------------------------------------
+uint32_t post_op(int32_t acc, int32_t bias, int scale, int shift, bool relu, int bits);
+
+// Fold an inference BatchNorm y = gamma * (x - mean) / sqrt(var + eps) + beta,
+// with x in accumulator units and y in units of out_step (the value of one
+// odd-grid step of the output codes, i.e. half the distance between codes),
+// into bias / scale / shift: y / out_step ~= (x + bias) * scale >> shift.
+// The largest shift (<= 31) that keeps |scale| <= 32767 is used.
+// gamma == 0 makes the channel the constant beta, which this form cannot
+// express; it folds to scale = 0, i.e. t = 0 for every input.
+void fold_batchnorm(double gamma, double beta, double mean, double var, double eps,
+                    double out_step, int32_t* bias, int16_t* scale, uint8_t* shift);
+
+// Per-OC parameters as written through prm_wr_*
+struct PostOps {
+    std::vector<int32_t> bias;
+    std::vector<int16_t> scale;
+    std::vector<uint8_t> shift;     // 0..31
+
+    uint32_t apply(int32_t acc, int oc, bool relu, int bits) const {
+        return post_op(acc, bias[oc], scale[oc], shift[oc], relu, bits);
+    }
+};
+
+//-----------------------------------------------------------------------------
+// 2-bit x 2-bit kernels (conv3x3_golden_simd.cpp)
+//-----------------------------------------------------------------------------
+enum class Kernel {
+    Reference,  // slice-level emulation of conv_core_lowbit (any mode)
+    Scalar,     // byte-pair table on packed codes
+    AVX2,
+    AVX512
+};
+
+// Best kernel supported by the running CPU
+Kernel      detect_kernel();
+const char* kernel_name(Kernel k);
+
+// Sum of muladd2_lut outputs over nbytes of packed 2-bit codes (4 per byte,
+// codes (0,1) and (2,3) of each byte form one LUT pair)
+uint64_t lut_dot2(Kernel k, const uint8_t* act, const uint8_t* wgt, size_t nbytes);
+
+//-----------------------------------------------------------------------------
+// Reference model
+//-----------------------------------------------------------------------------
+class ConvGolden {
+public:
+    // Streams are referenced, not copied; they must outlive the model.
+    // The packed kernel is only used for act_bits == wgt_bits == 2.
+    ConvGolden(const LayerConfig& cfg, const uint8_t* act_stream,
+               const uint8_t* wgt_stream, Kernel kernel = detect_kernel());
+
+    const LayerConfig& config() const { return cfg_; }
+    Kernel kernel() const { return kernel_; }
+
+    // conv_core_lowbit.partial for one (oy, ox, oc_grp, ic_grp) step:
+    // writes oc_ch_per_cycle() merged lanes. Like the core, the LUT offset
+    // is left in; the signed partial is partial - lut_offset().
+    void core_partial(int oy, int ox, int oc_grp, int ic_grp,
+                      int32_t* partial) const;
+
+    // conv_core_lowbit.lut_offset: the constant every partial carries,
+    // n_pairs * 9 * sum(4^s) * sum(4^g) over the act / wgt slices
+    uint32_t lut_offset() const;
+
+    // acc_buf after the last ic_grp of (oy, ox, oc_grp).
+    void compute_oc_group(int oy, int ox, int oc_grp, int32_t* out) const;
+
+    // All OC outputs of one pixel, oc ascending.
+    void compute_pixel(int oy, int ox, int32_t* out) const;
+
+    // Whole layer in (oy, ox, oc) order; out must hold out_elements().
+    void compute(int32_t* out) const;
+    std::vector<int32_t> compute() const;
+
+private:
+    // Window / weight rows for the packed kernel, padded to a multiple of 64
+    // bytes with codes whose LUT pairs evaluate to the neutral value 9.
+    static constexpr uint8_t PAD_ACT = 0xAA;  // a0 = a1 = +1
+    static constexpr uint8_t PAD_WGT = 0x66;  // w0 = +1, w1 = -1
+    bool   packed_path() const { return kernel_ != Kernel::Reference; }
+    // Windows with masked border taps take the reference path
+    bool   packed_window(int oy, int ox) const;
+    bool   in_image(int y, int x) const { return y >= 0 && y < cfg_.H && x >= 0 && x < cfg_.W; }
+    void   gather_window(int oy, int ox, uint8_t* win) const;
+    int32_t packed_output(const uint8_t* win, int oc) const;
+
+    uint32_t act_code(int y, int x, int ic) const {
+        return stream_get(act_, (size_t(y) * cfg_.W + x) * cfg_.IC + ic,
+                          cfg_.act_bits);
+    }
+    uint32_t wgt_code(int kh, int kw, int oc, int ic) const {
+        return stream_get(wgt_, ((size_t(kh) * KW + kw) * cfg_.OC + oc) * cfg_.IC + ic,
+                          cfg_.wgt_bits);
+    }
+
+    LayerConfig    cfg_;
+    const uint8_t* act_;
+    const uint8_t* wgt_;
+    Kernel         kernel_;
+
+    size_t               tap_bytes_ = 0;  // IC / 4
+    size_t               win_bytes_ = 0;  // 9 * IC / 4 rounded up to 64
+    std::vector<uint8_t> wgt_rows_;       // [oc][kh][kw][ic], packed 2-bit
+};
+
+//-----------------------------------------------------------------------------
+// Multithreaded layer evaluation (conv3x3_golden_mt.cpp)
+//
+// Work is split into (oy, oc_grp) tiles handed out row by row, the order in
+// which the accelerator produces its output: tile t covers row
+// t / num_oc_grp and OC group t % num_oc_grp for every ox. Each output is produced by the same
+// ConvGolden call as the single-threaded path, so results are bit-identical.
+// Rows become readable as soon as all their OC groups are finished, which
+// lets a checker compare while the RTL is still streaming.
+//-----------------------------------------------------------------------------
+class ParallelGolden {
+public:
+    // threads == 0 uses std::thread::hardware_concurrency(). Workers start
+    // immediately; the model must outlive this object.
+    explicit ParallelGolden(const ConvGolden& model, unsigned threads = 0);
+    ~ParallelGolden();
+
+    ParallelGolden(const ParallelGolden&) = delete;
+    ParallelGolden& operator=(const ParallelGolden&) = delete;
+
+    unsigned threads() const { return unsigned(workers_.size()); }
+
+    // Non-blocking completion check / blocking wait for output row oy.
+    // wait_row returns OW * OC outputs in (ox, oc) order.
+    bool           row_ready(int oy) const;
+    const int32_t* wait_row(int oy);
+
+    // Wait for the whole layer; returns all outputs in (oy, ox, oc) order.
+    const std::vector<int32_t>& wait_all();
+
+private:
+    void worker();
+
+    const ConvGolden&     model_;
+    const int             OW_, OC_, ocpc_, num_oc_grp_, num_tiles_;
+    std::vector<int32_t>  out_;
+
+    std::atomic<int>                    next_tile_{0};
+    std::unique_ptr<std::atomic<int>[]> row_tiles_done_;
+    std::mutex                          mutex_;
+    std::condition_variable             row_cv_;
+    std::vector<std::thread>            workers_;
+};
+
+//-----------------------------------------------------------------------------
+// Streaming output scoreboard (conv3x3_golden_sb.cpp)
+//
+// Checks out_data beats as they are accepted: each BUS_W beat is split into
+// BUS_W / 32 ACC_W lanes, lane 0 in the low word, and compared against the
+// expected stream in (oy, ox, oc) order. With cfg.out_bits < 32 a beat holds
+// BUS_W / out_bits codes in the packed stream layout, and the expected
+// values go through post_op() with cfg.relu and the attached PostOps
+// (bias 0, scale 1, shift 0 when none is set). Expected values are produced one
+// pixel at a time from the model, so memory stays at OC words whatever the
+// layer size; with a ParallelGolden attached they are read from its rows
+// instead, and a precomputed stream (e.g. from a TensorFile) can be used
+// directly. The first mismatch latches and all later beats are ignored.
+//-----------------------------------------------------------------------------
+class OutputScoreboard {
+public:
+    static constexpr int LANES = BUS_W / 32;
+
+    struct Mismatch {
+        size_t  index;
+        int     oy, ox, oc;
+        int32_t got, expected;
+    };
+
+    // pool is optional and must come from the same model
+    explicit OutputScoreboard(const ConvGolden& model, ParallelGolden* pool = nullptr);
+
+    // Check against out_elements() values already in (oy, ox, oc) order;
+    // the stream is referenced, not copied
+    OutputScoreboard(const LayerConfig& cfg, const int32_t* expected_stream);
+
+    // Post-op parameters for out_bits < 32; referenced, not copied
+    void set_post_ops(const PostOps* ops) { ops_ = ops; }
+
+    // Expect only output columns [ox0, ox0 + OW), the block of a ColumnTile,
+    // in (oy, ox, oc) order. Mismatches report layer coordinates. Call
+    // before the first beat.
+    void set_columns(int ox0, int OW);
+
+    // One accepted beat: LANES little-endian 32-bit words. Elements past the
+    // end of the layer (padding of the final beat) are not checked; a whole
+    // beat beyond the end is reported as a mismatch with oy = ox = oc = -1.
+    // Returns false once a mismatch has been seen.
+    bool push_beat(const uint32_t* words);
+
+    bool            failed() const { return failed_; }
+    const Mismatch& mismatch() const { return mismatch_; }
+    size_t          checked() const { return next_; }
+    size_t          expected_total() const { return total_; }
+    bool            complete() const { return !failed_ && next_ == total_; }
+
+private:
+    int32_t expected(size_t idx);
+
+    const ConvGolden*    model_;
+    ParallelGolden*      pool_;
+    const int32_t*       stream_ = nullptr;
+    const PostOps*       ops_ = nullptr;
+    const int            layer_OW_, OC_, bits_;
+    const bool           relu_;
+    int                  ox0_ = 0, OW_;  // Checked columns
+    size_t               total_;
+
+    size_t               next_ = 0;
+    long                 pixel_ = -1;    // oy * OW_ + ox - ox0_ held in pixel_buf_
+    const int32_t*       pixel_ptr_ = nullptr;
+    std::vector<int32_t> pixel_buf_;
+    bool                 failed_ = false;
+    Mismatch             mismatch_{};
+};
+
+//-----------------------------------------------------------------------------
+// Binary tensor file (conv3x3_golden_file.cpp)
+//
+// Stimulus and optional expected output for one layer, stored as the exact
+// BUS_W beats driven on wgt_in_data / act_in_data and read from out_data,
+// so a harness can stream straight from the mapped pages.
+//
+//   offset 0     TensorFileHeader (80 bytes, little-endian)
+//   wgt_offset   wgt_beats * BUS_BYTES   packed weight stream
+//   act_offset   act_beats * BUS_BYTES   packed activation stream
+//   out_offset   out_beats * BUS_BYTES   expected outputs, 4 x int32 per
+//                                        beat in (oy, ox, oc) order; absent
+//                                        when out_beats == 0
+// Section offsets are multiples of TENSOR_FILE_ALIGN (one page).
+//-----------------------------------------------------------------------------
+constexpr uint32_t TENSOR_FILE_VERSION = 1;
+constexpr size_t   TENSOR_FILE_ALIGN   = 4096;
+
+struct TensorFileHeader {
+    char     magic[8];         // "C3X3TNS\0"
+    uint32_t version;
+    uint32_t header_bytes;     // sizeof(TensorFileHeader)
+    uint16_t W, H, IC, OC;
+    uint8_t  stride, act_bits, wgt_bits;
+    uint8_t  pad;              // bit 0 cfg_pad, bit 1 cfg_pad_use_code
+    uint32_t pad_code;
+    uint64_t wgt_offset, wgt_beats;
+    uint64_t act_offset, act_beats;
+    uint64_t out_offset, out_beats;
+};
+static_assert(sizeof(TensorFileHeader) == 80, "TensorFileHeader layout");
+
+// Streams must hold cfg.wgt_beats() / cfg.act_beats() beats; out may be
+// nullptr, otherwise it holds cfg.out_elements() values. Returns nullptr on
+// success, otherwise a reason string.
+const char* write_tensor_file(const char* path, const LayerConfig& cfg,
+                              const uint8_t* wgt_stream, const uint8_t* act_stream,
+                              const int32_t* out);
+
+// Read-only memory mapping of a tensor file
+class TensorFile {
+public:
+    TensorFile() = default;
+    ~TensorFile();
+
+    TensorFile(const TensorFile&) = delete;
+    TensorFile& operator=(const TensorFile&) = delete;
+
+    // Maps the file and checks header, section bounds and beat counts
+    // against the layer; returns nullptr on success, otherwise a reason.
+    const char* open(const char* path);
+    void        close();
+
+    const LayerConfig& config() const { return cfg_; }
+    const uint8_t*     wgt_stream() const { return base_ + hdr_.wgt_offset; }
+    const uint8_t*     act_stream() const { return base_ + hdr_.act_offset; }
+    bool               has_output() const { return hdr_.out_beats != 0; }
+    const int32_t*     output() const {
+        return reinterpret_cast<const int32_t*>(base_ + hdr_.out_offset);
+    }
+
+private:
+    const uint8_t*   base_ = nullptr;
+    size_t           size_ = 0;
+    TensorFileHeader hdr_{};
+    LayerConfig      cfg_;
+};
+
+} // namespace golden
+
+#endif // CONV3X3_GOLDEN_H
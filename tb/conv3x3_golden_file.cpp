@@ -0,0 +1,155 @@
+//=============================================================================
+// conv3x3_golden_file.cpp - Binary tensor file writer and mmap reader
+//=============================================================================
+
+#include "conv3x3_golden.h"
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace golden {
+
+static const char TENSOR_FILE_MAGIC[8] = {'C', '3', 'X', '3', 'T', 'N', 'S', '\0'};
+
+static uint64_t align_up(uint64_t x) {
+    return (x + TENSOR_FILE_ALIGN - 1) / TENSOR_FILE_ALIGN * TENSOR_FILE_ALIGN;
+}
+
+static size_t out_beats(const LayerConfig& cfg) {
+    return (cfg.out_elements() * 32 + BUS_W - 1) / BUS_W;
+}
+
+//-----------------------------------------------------------------------------
+// Writer
+//-----------------------------------------------------------------------------
+const char* write_tensor_file(const char* path, const LayerConfig& cfg,
+                              const uint8_t* wgt_stream, const uint8_t* act_stream,
+                              const int32_t* out) {
+    TensorFileHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, TENSOR_FILE_MAGIC, sizeof(hdr.magic));
+    hdr.version      = TENSOR_FILE_VERSION;
+    hdr.header_bytes = sizeof(TensorFileHeader);
+    hdr.W        = uint16_t(cfg.W);
+    hdr.H        = uint16_t(cfg.H);
+    hdr.IC       = uint16_t(cfg.IC);
+    hdr.OC       = uint16_t(cfg.OC);
+    hdr.stride   = uint8_t(cfg.stride);
+    hdr.act_bits = uint8_t(cfg.act_bits);
+    hdr.wgt_bits = uint8_t(cfg.wgt_bits);
+    hdr.pad      = uint8_t(cfg.pad | (cfg.pad_use_code ? 2 : 0));
+    hdr.pad_code = cfg.pad_code;
+
+    hdr.wgt_offset = align_up(sizeof(hdr));
+    hdr.wgt_beats  = cfg.wgt_beats();
+    hdr.act_offset = align_up(hdr.wgt_offset + hdr.wgt_beats * BUS_BYTES);
+    hdr.act_beats  = cfg.act_beats();
+    hdr.out_offset = align_up(hdr.act_offset + hdr.act_beats * BUS_BYTES);
+    hdr.out_beats  = out ? out_beats(cfg) : 0;
+
+    FILE* f = fopen(path, "wb");
+    if (!f)
+        return "cannot create file";
+
+    // Sections are written at their offsets; the gaps read back as zeros
+    std::vector<uint8_t> out_tail;
+    bool ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1 &&
+              fseek(f, long(hdr.wgt_offset), SEEK_SET) == 0 &&
+              fwrite(wgt_stream, BUS_BYTES, hdr.wgt_beats, f) == hdr.wgt_beats &&
+              fseek(f, long(hdr.act_offset), SEEK_SET) == 0 &&
+              fwrite(act_stream, BUS_BYTES, hdr.act_beats, f) == hdr.act_beats;
+    if (ok && out) {
+        // Final beat is zero padded like output_packer's last partial beat
+        const size_t bytes = cfg.out_elements() * sizeof(int32_t);
+        out_tail.assign(hdr.out_beats * BUS_BYTES - bytes, 0);
+        ok = fseek(f, long(hdr.out_offset), SEEK_SET) == 0 &&
+             fwrite(out, 1, bytes, f) == bytes &&
+             fwrite(out_tail.data(), 1, out_tail.size(), f) == out_tail.size();
+    } else if (ok) {
+        // Pad the activation section to a whole page so the file size
+        // covers every offset
+        ok = fseek(f, long(hdr.out_offset) - 1, SEEK_SET) == 0 && fputc(0, f) != EOF;
+    }
+    if (fclose(f) != 0)
+        ok = false;
+    return ok ? nullptr : "write failed";
+}
+
+//-----------------------------------------------------------------------------
+// Reader
+//-----------------------------------------------------------------------------
+TensorFile::~TensorFile() {
+    close();
+}
+
+void TensorFile::close() {
+    if (base_)
+        munmap(const_cast<uint8_t*>(base_), size_);
+    base_ = nullptr;
+    size_ = 0;
+    memset(&hdr_, 0, sizeof(hdr_));
+    cfg_ = LayerConfig();
+}
+
+const char* TensorFile::open(const char* path) {
+    close();
+
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+        return "cannot open file";
+    struct stat st;
+    if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(TensorFileHeader)) {
+        ::close(fd);
+        return "file too small";
+    }
+    void* p = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED)
+        return "mmap failed";
+    base_ = static_cast<const uint8_t*>(p);
+    size_ = size_t(st.st_size);
+    // Streams are consumed front to back
+    madvise(p, size_, MADV_SEQUENTIAL);
+
+    const char* err = nullptr;
+    memcpy(&hdr_, base_, sizeof(hdr_));
+    cfg_.W        = hdr_.W;
+    cfg_.H        = hdr_.H;
+    cfg_.IC       = hdr_.IC;
+    cfg_.OC       = hdr_.OC;
+    cfg_.stride   = hdr_.stride;
+    cfg_.act_bits = hdr_.act_bits;
+    cfg_.wgt_bits = hdr_.wgt_bits;
+    cfg_.pad      = hdr_.pad & 1;
+    cfg_.pad_use_code = (hdr_.pad & 2) != 0;
+    cfg_.pad_code = hdr_.pad_code;
+
+    auto in_file = [&](uint64_t off, uint64_t beats) {
+        return off % TENSOR_FILE_ALIGN == 0 && off <= size_ &&
+               beats <= (size_ - off) / BUS_BYTES;
+    };
+    if (memcmp(hdr_.magic, TENSOR_FILE_MAGIC, sizeof(hdr_.magic)) != 0)
+        err = "bad magic";
+    else if (hdr_.version != TENSOR_FILE_VERSION)
+        err = "unsupported version";
+    else if (hdr_.header_bytes != sizeof(TensorFileHeader))
+        err = "header size";
+    else if (cfg_.act_slices() == 0 || cfg_.wgt_slices() == 0 ||
+             hdr_.wgt_beats != cfg_.wgt_beats() || hdr_.act_beats != cfg_.act_beats())
+        err = "beat count does not match layer";
+    else if (hdr_.out_beats != 0 && hdr_.out_beats != out_beats(cfg_))
+        err = "output beat count does not match layer";
+    else if (!in_file(hdr_.wgt_offset, hdr_.wgt_beats) ||
+             !in_file(hdr_.act_offset, hdr_.act_beats) ||
+             !in_file(hdr_.out_offset, hdr_.out_beats))
+        err = "section outside file";
+
+    if (err)
+        close();
+    return err;
+}
+
+} // namespace golden
@@ -0,0 +1,74 @@
+//=============================================================================
+// conv3x3_golden_mt.cpp - Multithreaded evaluation of the golden model
+//=============================================================================
+
+#include "conv3x3_golden.h"
+
+namespace golden {
+
+ParallelGolden::ParallelGolden(const ConvGolden& model, unsigned threads)
+    : model_(model),
+      OW_(model.config().OW()),
+      OC_(model.config().OC),
+      ocpc_(model.config().oc_ch_per_cycle()),
+      num_oc_grp_(model.config().num_oc_grp()),
+      num_tiles_(model.config().OH() * model.config().num_oc_grp()),
+      out_(model.config().out_elements()),
+      row_tiles_done_(new std::atomic<int>[model.config().OH()]) {
+    for (int oy = 0; oy < model.config().OH(); oy++)
+        row_tiles_done_[oy].store(0);
+
+    if (threads == 0)
+        threads = std::thread::hardware_concurrency();
+    if (threads == 0)
+        threads = 1;
+    for (unsigned t = 0; t < threads; t++)
+        workers_.emplace_back(&ParallelGolden::worker, this);
+}
+
+ParallelGolden::~ParallelGolden() {
+    // Let workers run out of tiles rather than abandoning them mid-tile
+    next_tile_.store(num_tiles_);
+    for (std::thread& t : workers_)
+        t.join();
+}
+
+void ParallelGolden::worker() {
+    for (;;) {
+        const int tile = next_tile_.fetch_add(1);
+        if (tile >= num_tiles_)
+            return;
+
+        const int oy     = tile / num_oc_grp_;
+        const int oc_grp = tile % num_oc_grp_;
+        for (int ox = 0; ox < OW_; ox++)
+            model_.compute_oc_group(oy, ox, oc_grp,
+                                    &out_[(size_t(oy) * OW_ + ox) * OC_ + oc_grp * ocpc_]);
+
+        if (row_tiles_done_[oy].fetch_add(1) + 1 == num_oc_grp_) {
+            // Take the lock so a waiter cannot miss the notification
+            std::lock_guard<std::mutex> lock(mutex_);
+            row_cv_.notify_all();
+        }
+    }
+}
+
+bool ParallelGolden::row_ready(int oy) const {
+    return row_tiles_done_[oy].load() == num_oc_grp_;
+}
+
+const int32_t* ParallelGolden::wait_row(int oy) {
+    if (!row_ready(oy)) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        row_cv_.wait(lock, [&] { return row_ready(oy); });
+    }
+    return &out_[size_t(oy) * OW_ * OC_];
+}
+
+const std::vector<int32_t>& ParallelGolden::wait_all() {
+    for (int oy = 0; oy < model_.config().OH(); oy++)
+        wait_row(oy);
+    return out_;
+}
+
+} // namespace golden
@@ -0,0 +1,225 @@
+//=============================================================================
+// conv3x3_golden_pack.cpp - Bulk packing of element codes into bus streams
+//
+// Layout is the one weight_buffer::extract_element and the
+// feature_line_buffer input buffer read: element i at bits
+// [i*bits +: bits], LSB first, little-endian bytes across BUS_W beats.
+//
+//   2-bit  32 codes -> 8 bytes    AVX2 maddubs/madd, BMI2 pext / pdep
+//   4-bit  32 codes -> 16 bytes   AVX2 maddubs + packus, BMI2 pext / pdep
+//   8-bit  identity copy
+//   16-bit identity copy (little-endian host)
+// The kernel is chosen at runtime (detect_pack_kernel); the scalar path
+// handles tails and other CPUs.
+//=============================================================================
+
+#include "conv3x3_golden.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define GOLDEN_X86 1
+#else
+#define GOLDEN_X86 0
+#endif
+
+namespace golden {
+
+//-----------------------------------------------------------------------------
+// Scalar
+//-----------------------------------------------------------------------------
+static void pack_scalar(const uint8_t* codes, size_t n, int bits, uint8_t* out) {
+    const int per_byte = 8 / bits;
+    const uint32_t mask = (1u << bits) - 1;
+    size_t i = 0;
+    for (; i + per_byte <= n; i += per_byte) {
+        uint32_t b = 0;
+        for (int k = 0; k < per_byte; k++)
+            b |= (codes[i + k] & mask) << (k * bits);
+        *out++ = uint8_t(b);
+    }
+    if (i < n) {
+        uint32_t b = 0;
+        for (int k = 0; i + k < n; k++)
+            b |= (codes[i + k] & mask) << (k * bits);
+        *out = uint8_t(b);
+    }
+}
+
+// One stream byte -> its four 2-bit codes
+static const uint8_t (*unpack2_table())[4] {
+    static uint8_t table[256][4];
+    static bool init = [] {
+        for (uint32_t b = 0; b < 256; b++)
+            for (int k = 0; k < 4; k++)
+                table[b][k] = uint8_t((b >> (2 * k)) & 3);
+        return true;
+    }();
+    (void)init;
+    return table;
+}
+
+static void unpack_scalar(const uint8_t* stream, size_t n, int bits, uint8_t* codes) {
+    const int per_byte = 8 / bits;
+    size_t i = 0;
+    if (bits == 2) {
+        const uint8_t (*table)[4] = unpack2_table();
+        for (; i + 4 <= n; i += 4)
+            memcpy(codes + i, table[stream[i / 4]], 4);
+    } else {
+        for (; i + 2 <= n; i += 2) {
+            codes[i]     = stream[i / 2] & 0xF;
+            codes[i + 1] = stream[i / 2] >> 4;
+        }
+    }
+    for (; i < n; i++)
+        codes[i] = (stream[i / per_byte] >> ((i % per_byte) * bits)) & ((1u << bits) - 1);
+}
+
+#if GOLDEN_X86
+//-----------------------------------------------------------------------------
+// BMI2: pext gathers the low bits of 8 code bytes, pdep scatters them back
+//-----------------------------------------------------------------------------
+static uint64_t code_mask(int bits) {
+    return bits == 2 ? 0x0303030303030303ull : 0x0F0F0F0F0F0F0F0Full;
+}
+
+__attribute__((target("bmi2")))
+static size_t pack_bmi2(const uint8_t* codes, size_t n, int bits, uint8_t* out) {
+    const uint64_t mask = code_mask(bits);
+    const size_t out_bytes = bits;  // 8 codes -> bits bytes
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t v;
+        memcpy(&v, codes + i, 8);
+        uint64_t p = _pext_u64(v, mask);
+        memcpy(out + i / 8 * out_bytes, &p, out_bytes);
+    }
+    return i;
+}
+
+__attribute__((target("bmi2")))
+static size_t unpack_bmi2(const uint8_t* stream, size_t n, int bits, uint8_t* codes) {
+    const uint64_t mask = code_mask(bits);
+    const size_t in_bytes = bits;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t p = 0;
+        memcpy(&p, stream + i / 8 * in_bytes, in_bytes);
+        uint64_t v = _pdep_u64(p, mask);
+        memcpy(codes + i, &v, 8);
+    }
+    return i;
+}
+
+//-----------------------------------------------------------------------------
+// AVX2 pack: multiply-add adjacent codes into wider fields, then compact
+//-----------------------------------------------------------------------------
+__attribute__((target("avx2")))
+static size_t pack_avx2(const uint8_t* codes, size_t n, int bits, uint8_t* out) {
+    size_t i = 0;
+    if (bits == 2) {
+        const __m256i m3    = _mm256_set1_epi8(0x03);
+        const __m256i mul4  = _mm256_set1_epi16(0x0401);      // c0 + 4 * c1
+        const __m256i mul16 = _mm256_set1_epi32(0x00100001);  // w0 + 16 * w1
+        // byte 0 of each dword -> bytes 0..3 of each 128-bit lane
+        const __m256i gather = _mm256_setr_epi8(
+            0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+            0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m256i lanes = _mm256_setr_epi32(0, 4, 1, 1, 1, 1, 1, 1);
+        for (; i + 32 <= n; i += 32) {
+            __m256i v = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)(codes + i)), m3);
+            __m256i w = _mm256_madd_epi16(_mm256_maddubs_epi16(v, mul4), mul16);
+            w = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(w, gather), lanes);
+            _mm_storel_epi64((__m128i*)(out + i / 4), _mm256_castsi256_si128(w));
+        }
+    } else {
+        const __m256i m15   = _mm256_set1_epi8(0x0F);
+        const __m256i mul16 = _mm256_set1_epi16(0x1001);      // c0 + 16 * c1
+        for (; i + 32 <= n; i += 32) {
+            __m256i v = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)(codes + i)), m15);
+            __m256i w = _mm256_maddubs_epi16(v, mul16);
+            w = _mm256_permute4x64_epi64(_mm256_packus_epi16(w, w), 0x08);
+            _mm_storeu_si128((__m128i*)(out + i / 2), _mm256_castsi256_si128(w));
+        }
+    }
+    return i;
+}
+#endif // GOLDEN_X86
+
+//-----------------------------------------------------------------------------
+// Dispatch
+//-----------------------------------------------------------------------------
+PackKernel detect_pack_kernel() {
+#if GOLDEN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi2")) return PackKernel::AVX2;
+    if (__builtin_cpu_supports("bmi2")) return PackKernel::BMI2;
+#endif
+    return PackKernel::Scalar;
+}
+
+const char* pack_kernel_name(PackKernel k) {
+    switch (k) {
+        case PackKernel::Scalar: return "scalar";
+        case PackKernel::BMI2:   return "bmi2";
+        case PackKernel::AVX2:   return "avx2";
+    }
+    return "?";
+}
+
+void pack_codes(const uint8_t* codes, size_t n, int bits, uint8_t* stream, PackKernel k) {
+    if (bits == 8) {
+        memcpy(stream, codes, n);
+        return;
+    }
+    size_t done = 0;
+#if GOLDEN_X86
+    switch (k) {
+        case PackKernel::AVX2: done = pack_avx2(codes, n, bits, stream); break;
+        case PackKernel::BMI2: done = pack_bmi2(codes, n, bits, stream); break;
+        default: break;
+    }
+#else
+    (void)k;
+#endif
+    pack_scalar(codes + done, n - done, bits, stream + done * bits / 8);
+}
+
+void unpack_codes(const uint8_t* stream, size_t n, int bits, uint8_t* codes, PackKernel k) {
+    if (bits == 8) {
+        memcpy(codes, stream, n);
+        return;
+    }
+    size_t done = 0;
+#if GOLDEN_X86
+    // pdep is the widening path for both BMI2 and AVX2 capable CPUs
+    if (k != PackKernel::Scalar)
+        done = unpack_bmi2(stream, n, bits, codes);
+#else
+    (void)k;
+#endif
+    unpack_scalar(stream + done * bits / 8, n - done, bits, codes + done);
+}
+
+void pack_codes(const uint16_t* codes, size_t n, uint8_t* stream) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    memcpy(stream, codes, n * 2);
+#else
+    for (size_t i = 0; i < n; i++) {
+        stream[2 * i]     = uint8_t(codes[i]);
+        stream[2 * i + 1] = uint8_t(codes[i] >> 8);
+    }
+#endif
+}
+
+void unpack_codes(const uint8_t* stream, size_t n, uint16_t* codes) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    memcpy(codes, stream, n * 2);
+#else
+    for (size_t i = 0; i < n; i++)
+        codes[i] = uint16_t(stream[2 * i] | (stream[2 * i + 1] << 8));
+#endif
+}
+
+} // namespace golden
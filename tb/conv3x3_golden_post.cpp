@@ -0,0 +1,48 @@
+//=============================================================================
+// conv3x3_golden_post.cpp - Output post-ops (other_ops_stub.sv)
+//=============================================================================
+
+#include "conv3x3_golden.h"
+#include <cmath>
+
+namespace golden {
+
+uint32_t post_op(int32_t acc, int32_t bias, int scale, int shift, bool relu, int bits) {
+    // 33-bit sum and 49-bit product as in the RTL; arithmetic shifts floor
+    int64_t t = (int64_t(acc) + bias) * int16_t(scale);
+    if (shift > 0)
+        t += int64_t(1) << (shift - 1);
+    t >>= shift;
+    if (relu && t < 0)
+        t = 0;
+    const int64_t code_max = (int64_t(1) << bits) - 1;
+    int64_t code = (t + code_max) >> 1;
+    if (code < 0)
+        code = 0;
+    else if (code > code_max)
+        code = code_max;
+    return uint32_t(code);
+}
+
+void fold_batchnorm(double gamma, double beta, double mean, double var, double eps,
+                    double out_step, int32_t* bias, int16_t* scale, uint8_t* shift) {
+    // y / out_step = m * (x + b)
+    const double m = gamma / (std::sqrt(var + eps) * out_step);
+    if (m == 0.0) {
+        *bias  = 0;
+        *scale = 0;
+        *shift = 0;
+        return;
+    }
+    const double b = beta / (m * out_step) - mean;
+    *bias = int32_t(std::lround(std::fmax(std::fmin(b, 2147483647.0), -2147483648.0)));
+
+    int sh = 31;
+    while (sh > 0 && std::fabs(m) * std::ldexp(1.0, sh) > 32767.0)
+        sh--;
+    const double q = std::fmax(std::fmin(std::round(m * std::ldexp(1.0, sh)), 32767.0), -32767.0);
+    *scale = int16_t(q);
+    *shift = uint8_t(sh);
+}
+
+} // namespace golden
@@ -0,0 +1,86 @@
+//=============================================================================
+// conv3x3_golden_sb.cpp - Streaming output scoreboard
+//=============================================================================
+
+#include "conv3x3_golden.h"
+
+namespace golden {
+
+OutputScoreboard::OutputScoreboard(const ConvGolden& model, ParallelGolden* pool)
+    : model_(&model),
+      pool_(pool),
+      layer_OW_(model.config().OW()),
+      OC_(model.config().OC),
+      bits_(model.config().out_bits),
+      relu_(model.config().relu),
+      OW_(layer_OW_),
+      total_(model.config().out_elements()),
+      pixel_buf_(pool ? 0 : model.config().OC) {}
+
+OutputScoreboard::OutputScoreboard(const LayerConfig& cfg, const int32_t* expected_stream)
+    : model_(nullptr),
+      pool_(nullptr),
+      stream_(expected_stream),
+      layer_OW_(cfg.OW()),
+      OC_(cfg.OC),
+      bits_(cfg.out_bits),
+      relu_(cfg.relu),
+      OW_(layer_OW_),
+      total_(cfg.out_elements()) {}
+
+void OutputScoreboard::set_columns(int ox0, int OW) {
+    ox0_   = ox0;
+    OW_    = OW;
+    total_ = total_ / size_t(layer_OW_) * size_t(OW);
+}
+
+int32_t OutputScoreboard::expected(size_t idx) {
+    const long pixel = long(idx / OC_);
+    const int  oy    = int(pixel / OW_);
+    const int  ox    = ox0_ + int(pixel % OW_);
+    if (stream_)
+        return stream_[(size_t(oy) * layer_OW_ + ox) * OC_ + idx % OC_];
+    if (pixel != pixel_) {
+        if (pool_) {
+            pixel_ptr_ = pool_->wait_row(oy) + size_t(ox) * OC_;
+        } else {
+            model_->compute_pixel(oy, ox, pixel_buf_.data());
+            pixel_ptr_ = pixel_buf_.data();
+        }
+        pixel_ = pixel;
+    }
+    return pixel_ptr_[idx % OC_];
+}
+
+bool OutputScoreboard::push_beat(const uint32_t* words) {
+    if (failed_)
+        return false;
+    if (next_ == total_) {
+        // A beat after the last output is an error in itself
+        failed_   = true;
+        mismatch_ = {total_, -1, -1, -1, int32_t(words[0]), 0};
+        return false;
+    }
+    const uint8_t* beat = reinterpret_cast<const uint8_t*>(words);
+    for (int e = 0; e < BUS_W / bits_ && next_ < total_; e++, next_++) {
+        int32_t got, exp = expected(next_);
+        if (bits_ == 32) {
+            got = int32_t(words[e]);
+            if (relu_ && exp < 0)
+                exp = 0;
+        } else {
+            got = int32_t(stream_get(beat, size_t(e), bits_));
+            exp = int32_t(ops_ ? ops_->apply(exp, int(next_ % OC_), relu_, bits_)
+                               : post_op(exp, 0, 1, 0, relu_, bits_));
+        }
+        if (got != exp) {
+            failed_   = true;
+            mismatch_ = {next_, int(next_ / (size_t(OW_) * OC_)), ox0_ + int(next_ / OC_ % OW_),
+                         int(next_ % OC_), got, exp};
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace golden
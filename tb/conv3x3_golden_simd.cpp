@@ -0,0 +1,172 @@
+//=============================================================================
+// conv3x3_golden_simd.cpp - Vectorized 2-bit x 2-bit kernels for the golden model
+//
+// All kernels compute the same quantity as the unsigned reduction tree in
+// conv_core_lowbit: the sum of muladd2_lut outputs over packed 2-bit codes.
+// Each byte holds 4 codes; codes (0,1) and (2,3) of a byte form the
+// (a0,w0,a1,w1) pairs of one LUT, exactly as lanes (2p, 2p+1) do in RTL.
+//
+// Vector identity (per byte lane):
+//   t_k   = decode2(a_k) * decode2(w_k) + 9      via 16-entry pshufb table
+//   lut   = (t_0 + t_1) >> 1 = (pair_sum + 18) >> 1
+// pair_sum is always even (odd * odd + odd * odd), so the halving is exact
+// and can be done with the rounding byte average (avg_epu8).
+//=============================================================================
+
+#include "conv3x3_golden.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define GOLDEN_X86 1
+#else
+#define GOLDEN_X86 0
+#endif
+
+namespace golden {
+
+//-----------------------------------------------------------------------------
+// Portable scalar kernel: one 64K-entry table indexed by {act byte, wgt byte}
+// returns the sum of the two LUT outputs encoded in that byte pair.
+//-----------------------------------------------------------------------------
+static const uint8_t* byte_pair_table() {
+    static uint8_t table[65536];
+    static bool init = [] {
+        for (uint32_t a = 0; a < 256; a++)
+            for (uint32_t w = 0; w < 256; w++)
+                table[(a << 8) | w] = uint8_t(
+                    muladd2_lut(a & 3, w & 3, (a >> 2) & 3, (w >> 2) & 3) +
+                    muladd2_lut((a >> 4) & 3, (w >> 4) & 3, (a >> 6) & 3, (w >> 6) & 3));
+        return true;
+    }();
+    (void)init;
+    return table;
+}
+
+static uint64_t lut_dot2_scalar(const uint8_t* act, const uint8_t* wgt, size_t nbytes) {
+    const uint8_t* table = byte_pair_table();
+    uint64_t sum = 0;
+    for (size_t i = 0; i < nbytes; i++)
+        sum += table[(uint32_t(act[i]) << 8) | wgt[i]];
+    return sum;
+}
+
+#if GOLDEN_X86
+// decode2(a) * decode2(w) + 9, indexed by {w[1:0], a[1:0]}
+#define PROD9_TABLE_128                                          \
+    18, 12, 6, 0,   /* w = -3: a = -3, -1, +1, +3 */             \
+    12, 10, 8, 6,   /* w = -1 */                                 \
+     6,  8, 10, 12, /* w = +1 */                                 \
+     0,  6, 12, 18  /* w = +3 */
+
+__attribute__((target("avx2")))
+static uint64_t lut_dot2_avx2(const uint8_t* act, const uint8_t* wgt, size_t nbytes) {
+    const __m256i table = _mm256_setr_epi8(PROD9_TABLE_128, PROD9_TABLE_128);
+    const __m256i m3    = _mm256_set1_epi8(0x03);
+    const __m256i m12   = _mm256_set1_epi8(0x0C);
+    __m256i acc = _mm256_setzero_si256();
+
+    size_t i = 0;
+    for (; i + 32 <= nbytes; i += 32) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(act + i));
+        __m256i w = _mm256_loadu_si256((const __m256i*)(wgt + i));
+
+        // idx_k = a_k | (w_k << 2)
+        __m256i i0 = _mm256_or_si256(_mm256_and_si256(a, m3),
+                                     _mm256_and_si256(_mm256_slli_epi16(w, 2), m12));
+        __m256i i1 = _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi16(a, 2), m3),
+                                     _mm256_and_si256(w, m12));
+        __m256i i2 = _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi16(a, 4), m3),
+                                     _mm256_and_si256(_mm256_srli_epi16(w, 2), m12));
+        __m256i i3 = _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi16(a, 6), m3),
+                                     _mm256_and_si256(_mm256_srli_epi16(w, 4), m12));
+
+        __m256i lut0 = _mm256_avg_epu8(_mm256_shuffle_epi8(table, i0),
+                                       _mm256_shuffle_epi8(table, i1));
+        __m256i lut1 = _mm256_avg_epu8(_mm256_shuffle_epi8(table, i2),
+                                       _mm256_shuffle_epi8(table, i3));
+
+        // <= 36 per byte, widen with SAD into four 64-bit partial sums
+        acc = _mm256_add_epi64(acc, _mm256_sad_epu8(_mm256_add_epi8(lut0, lut1),
+                                                    _mm256_setzero_si256()));
+    }
+
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, acc);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] +
+           lut_dot2_scalar(act + i, wgt + i, nbytes - i);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static uint64_t lut_dot2_avx512(const uint8_t* act, const uint8_t* wgt, size_t nbytes) {
+    alignas(64) static const uint8_t table_bytes[64] = {
+        PROD9_TABLE_128, PROD9_TABLE_128, PROD9_TABLE_128, PROD9_TABLE_128};
+    const __m512i table = _mm512_load_si512((const void*)table_bytes);
+    const __m512i m3    = _mm512_set1_epi8(0x03);
+    const __m512i m12   = _mm512_set1_epi8(0x0C);
+    __m512i acc = _mm512_setzero_si512();
+
+    size_t i = 0;
+    for (; i + 64 <= nbytes; i += 64) {
+        __m512i a = _mm512_loadu_si512((const void*)(act + i));
+        __m512i w = _mm512_loadu_si512((const void*)(wgt + i));
+
+        __m512i i0 = _mm512_or_si512(_mm512_and_si512(a, m3),
+                                     _mm512_and_si512(_mm512_slli_epi16(w, 2), m12));
+        __m512i i1 = _mm512_or_si512(_mm512_and_si512(_mm512_srli_epi16(a, 2), m3),
+                                     _mm512_and_si512(w, m12));
+        __m512i i2 = _mm512_or_si512(_mm512_and_si512(_mm512_srli_epi16(a, 4), m3),
+                                     _mm512_and_si512(_mm512_srli_epi16(w, 2), m12));
+        __m512i i3 = _mm512_or_si512(_mm512_and_si512(_mm512_srli_epi16(a, 6), m3),
+                                     _mm512_and_si512(_mm512_srli_epi16(w, 4), m12));
+
+        __m512i lut0 = _mm512_avg_epu8(_mm512_shuffle_epi8(table, i0),
+                                       _mm512_shuffle_epi8(table, i1));
+        __m512i lut1 = _mm512_avg_epu8(_mm512_shuffle_epi8(table, i2),
+                                       _mm512_shuffle_epi8(table, i3));
+
+        acc = _mm512_add_epi64(acc, _mm512_sad_epu8(_mm512_add_epi8(lut0, lut1),
+                                                    _mm512_setzero_si512()));
+    }
+
+    alignas(64) uint64_t lanes[8];
+    _mm512_store_si512((void*)lanes, acc);
+    uint64_t sum = 0;
+    for (int l = 0; l < 8; l++)
+        sum += lanes[l];
+    return sum + lut_dot2_scalar(act + i, wgt + i, nbytes - i);
+}
+#endif // GOLDEN_X86
+
+//-----------------------------------------------------------------------------
+// Dispatch
+//-----------------------------------------------------------------------------
+Kernel detect_kernel() {
+#if GOLDEN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512bw")) return Kernel::AVX512;
+    if (__builtin_cpu_supports("avx2"))     return Kernel::AVX2;
+#endif
+    return Kernel::Scalar;
+}
+
+const char* kernel_name(Kernel k) {
+    switch (k) {
+        case Kernel::Reference: return "reference";
+        case Kernel::Scalar:    return "scalar";
+        case Kernel::AVX2:      return "avx2";
+        case Kernel::AVX512:    return "avx512";
+    }
+    return "?";
+}
+
+uint64_t lut_dot2(Kernel k, const uint8_t* act, const uint8_t* wgt, size_t nbytes) {
+    switch (k) {
+#if GOLDEN_X86
+        case Kernel::AVX512: return lut_dot2_avx512(act, wgt, nbytes);
+        case Kernel::AVX2:   return lut_dot2_avx2(act, wgt, nbytes);
+#endif
+        default:             return lut_dot2_scalar(act, wgt, nbytes);
+    }
+}
+
+} // namespace golden
@@ -83,6 +83,8 @@ module tb_conv3x3_accel;
     logic        req_valid;
     logic        req_ready;
     logic        wgt_load_done;
+    logic        wgt_rd_buf_ready;      // Read buffer holds a full layer
+    logic        wgt_rd_release;        // Layer done, free the read buffer
     
     // Weight Buffer -> Conv Core
     logic [1:0]  wgt2 [0:OC2_LANES-1][0:KH-1][0:KW-1][0:IC2_LANES-1];
@@ -93,9 +95,11 @@ module tb_conv3x3_accel;
     logic        core_out_valid;
     logic        core_out_ready;
     logic signed [ACC_W-1:0] partial [0:OC2_LANES-1];
+    logic signed [ACC_W-1:0] lut_offset;    // Carried by every partial
     
-    // Accumulator signals
-    logic signed [ACC_W-1:0] acc_out_data;
+    // Accumulator signals: one OC group (r_OC_CH_PER_CYCLE lanes) per transfer
+    logic signed [ACC_W-1:0] acc_out_data [0:OC2_LANES-1];
+    logic [4:0]  acc_out_count;
     logic        acc_out_valid;
     logic        acc_out_ready;
     logic        acc_out_last;
@@ -119,6 +123,11 @@ module tb_conv3x3_accel;
         .cfg_IC(cfg_IC),
         .cfg_act_bits(cfg_act_bits),
         .cfg_stride(cfg_stride),
+        .cfg_pad(1'b0),
+        .cfg_pad_use_code(1'b0),
+        .cfg_pad_code(16'd0),
+        .cfg_tile_x0(16'd0),            // Whole rows, no column tiles
+        .cfg_tile_W(16'd0),
         .cfg_valid(cfg_valid),
         .cfg_ready(cfg_ready),
         .act_in_valid(act_in_valid),
@@ -131,6 +140,7 @@ module tb_conv3x3_accel;
         .win_x(win_x),
         .win_ic_grp(win_ic_grp),
         .win_act2(win_act2),
+        .win_mask(),
         .linebuf_ready(linebuf_ready),
         .layer_done(linebuf_done)
     );
@@ -148,6 +158,7 @@ module tb_conv3x3_accel;
         .cfg_IC(cfg_IC),
         .cfg_OC(cfg_OC),
         .cfg_wgt_bits(cfg_wgt_bits),
+        .cfg_act_bits(cfg_act_bits),
         .cfg_valid(cfg_valid && cfg_ready),
         .cfg_ready(),
         .wgt_in_valid(wgt_in_valid),
@@ -155,6 +166,8 @@ module tb_conv3x3_accel;
         .wgt_in_data(wgt_in_data),
         .wgt_in_last(wgt_in_last),
         .wgt_load_done(wgt_load_done),
+        .rd_buf_ready(wgt_rd_buf_ready),
+        .rd_release(wgt_rd_release),
         .req_oc_grp(req_oc_grp),
         .req_ic_grp(req_ic_grp),
         .req_valid(req_valid),
@@ -177,25 +190,32 @@ module tb_conv3x3_accel;
         .in_valid(win_valid && wgt_valid),
         .in_ready(win_ready),
         .act2(win_act2),
+        .act_mask('{default: '{default: 1'b1}}),
         .wgt2(wgt2),
         .act_bits(cfg_act_bits),
         .wgt_bits(cfg_wgt_bits),
+        .in_tag(1'b0),
         .out_valid(core_out_valid),
         .out_ready(core_out_ready),
-        .partial(partial)
+        .partial(partial),
+        .out_tag(),
+        .lut_offset(lut_offset)
     );
     assign wgt_ready = win_ready;
     
     // Output Packer
     output_packer #(
         .ACC_W(ACC_W),
-        .BUS_W(BUS_W)
+        .BUS_W(BUS_W),
+        .LANES(OC2_LANES)
     ) u_outpacker (
         .clk(clk),
         .rst_n(rst_n),
+        .cfg_out_bits(6'd32),           // Raw ACC_W results
         .in_valid(acc_out_valid),
         .in_ready(acc_out_ready),
         .in_data(acc_out_data),
+        .in_count(acc_out_count),
         .in_last(acc_out_last),
         .out_valid(out_valid),
         .out_ready(out_ready),
@@ -230,7 +250,6 @@ module tb_conv3x3_accel;
     
     // Accumulator
     logic signed [ACC_W-1:0] acc_reg [0:15];
-    logic [4:0]  acc_cnt;
     logic        acc_busy;
     
     // Output counter
@@ -301,7 +320,7 @@ module tb_conv3x3_accel;
                             // First IC group - initialize accumulator
                             for (int i = 0; i < 16; i++) begin
                                 if (i < r_OC_CH_PER_CYCLE)
-                                    acc_reg[i] <= partial[i];
+                                    acc_reg[i] <= partial[i] - lut_offset;
                                 else
                                     acc_reg[i] <= '0;
                             end
@@ -309,7 +328,7 @@ module tb_conv3x3_accel;
                             // Accumulate
                             for (int i = 0; i < 16; i++) begin
                                 if (i < r_OC_CH_PER_CYCLE)
-                                    acc_reg[i] <= acc_reg[i] + partial[i];
+                                    acc_reg[i] <= acc_reg[i] + partial[i] - lut_offset;
                                 else
                                     acc_reg[i] <= acc_reg[i];
                             end
@@ -377,7 +396,7 @@ module tb_conv3x3_accel;
             end
             
             ST_WAIT_WGT_DONE: begin
-                if (wgt_load_done) next_state = ST_PROCESS;
+                if (wgt_rd_buf_ready) next_state = ST_PROCESS;
             end
             
             ST_PROCESS: begin
@@ -398,6 +417,10 @@ module tb_conv3x3_accel;
         endcase
     end
     
+    // Each test loads a new layer: release the weight buffer at layer end
+    // so the ping-pong buffers do not both stay full
+    assign wgt_rd_release = (state == ST_DONE);
+    
     // Output to conv_core
     assign req_oc_grp = cur_oc_grp;
     assign req_ic_grp = cur_ic_grp;
@@ -405,24 +428,11 @@ module tb_conv3x3_accel;
     assign win_ready = (state == ST_PROCESS) && req_ready && !acc_busy;
     assign core_out_ready = (state == ST_PROCESS) && !acc_busy;
     
-    // Output from accumulator
+    // Output from accumulator: the whole OC group in one transfer
     assign acc_out_valid = acc_busy;
-    assign acc_out_data = acc_reg[acc_cnt];
-    assign acc_out_last = (out_elem_cnt + r_OC_CH_PER_CYCLE >= total_out_elems) && 
-                          (acc_cnt + 1 >= r_OC_CH_PER_CYCLE);
-    
-    always_ff @(posedge clk or negedge rst_n) begin
-        if (!rst_n) begin
-            acc_cnt <= '0;
-        end else begin
-            if (acc_out_valid && acc_out_ready) begin
-                if (acc_cnt + 1 >= r_OC_CH_PER_CYCLE)
-                    acc_cnt <= '0;
-                else
-                    acc_cnt <= acc_cnt + 1'b1;
-            end
-        end
-    end
+    assign acc_out_data  = acc_reg;
+    assign acc_out_count = r_OC_CH_PER_CYCLE[4:0];
+    assign acc_out_last  = (out_elem_cnt + r_OC_CH_PER_CYCLE >= total_out_elems);
 
     //========================================================================
     // Golden Model Functions
@@ -555,6 +565,7 @@ module tb_conv3x3_accel;
         output logic [BUS_W-1:0] beats[$]
     );
         logic [BUS_W-1:0] current_beat;
+        logic [BUS_W-1:0] elem_mask;
         int bit_pos;
         int elems_per_beat;
         
@@ -563,11 +574,11 @@ module tb_conv3x3_accel;
         bit_pos = 0;
         beats = {};
         
+        elem_mask = (BUS_W'(1) << bits_per_elem) - 1;
+        
         for (int i = 0; i < num_elems; i++) begin
-            // Pack element at current position
-            for (int b = 0; b < bits_per_elem; b++) begin
-                current_beat[bit_pos + b] = data[i][b];
-            end
+            // Pack element at current position (one masked OR per element)
+            current_beat |= (BUS_W'(data[i]) & elem_mask) << bit_pos;
             bit_pos += bits_per_elem;
             
             // Beat is full
@@ -0,0 +1,332 @@
+//=============================================================================
+// tb_driver.h - Cycle driver for the Verilator model of conv3x3_accel_top
+//
+// AccelDriver::tick() advances one clock cycle with one eval() per edge,
+// matching the SV @(posedge clk) view of the design:
+//   1. clk = 0, eval()  inputs set since the last tick settle, so *_ready
+//                       and out_* are valid for this cycle
+//   2. handshakes (valid && ready) are sampled, as just before the posedge
+//   3. clk = 1, eval()  registers update
+// Weight / activation sources and the output sink are serviced inside
+// tick(), so a test is a short sequence of run_until() calls instead of a
+// hand-written valid/ready loop per stream. Sources present beats
+// back-to-back; valid only drops when a stream is exhausted.
+//=============================================================================
+
+#ifndef TB_DRIVER_H
+#define TB_DRIVER_H
+
+#include <verilated.h>
+#if VM_TRACE_FST
+#include <verilated_fst_c.h>
+#elif VM_TRACE
+#include <verilated_vcd_c.h>
+#endif
+#include "Vconv3x3_accel_top.h"
+#include "conv3x3_golden.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct TraceOptions {
+    bool        enable = false;
+    std::string file;                  // default waveform.fst / waveform.vcd
+    uint64_t    start = 0;             // first clock cycle dumped
+    uint64_t    stop  = UINT64_MAX;    // last clock cycle dumped
+    std::string scope;                 // instance to dump, empty = whole design
+    int         depth = 99;
+};
+
+//-----------------------------------------------------------------------------
+// Waveform dump limited to a cycle window. Format follows the build:
+// FST with --trace-fst, VCD with --trace, nothing otherwise.
+//-----------------------------------------------------------------------------
+class Tracer {
+public:
+    Tracer(VerilatedContext* contextp, Vconv3x3_accel_top* top, const TraceOptions& opt)
+        : contextp_(contextp), start_(opt.start), stop_(opt.stop) {
+#if VM_TRACE
+        // contextp->traceEverOn(true) must already have been called before
+        // the model was constructed
+        if (!opt.enable)
+            return;
+#if VM_TRACE_FST
+        tfp_.reset(new VerilatedFstC);
+        std::string file = opt.file.empty() ? "waveform.fst" : opt.file;
+#else
+        tfp_.reset(new VerilatedVcdC);
+        std::string file = opt.file.empty() ? "waveform.vcd" : opt.file;
+#endif
+        if (!opt.scope.empty()) {
+            // Scope names are hierarchical from the top module
+            std::string scope = opt.scope;
+            if (scope.find('.') == std::string::npos)
+                scope = "conv3x3_accel_top." + scope;
+            tfp_->dumpvars(opt.depth, scope);
+        }
+        top->trace(tfp_.get(), opt.depth);
+        tfp_->open(file.c_str());
+        printf("Tracing to %s, cycles [%llu, %llu]%s%s\n", file.c_str(),
+               (unsigned long long)start_, (unsigned long long)stop_,
+               opt.scope.empty() ? "" : ", scope ", opt.scope.c_str());
+#else
+        (void)top;
+        if (opt.enable)
+            printf("[WARN] --trace ignored: model built without --trace / --trace-fst\n");
+#endif
+    }
+
+    ~Tracer() { close(); }
+
+    // Called after every eval(); time advances by one per half cycle
+    void dump() {
+#if VM_TRACE
+        if (tfp_) {
+            uint64_t cycle = contextp_->time() / 2;
+            if (cycle > stop_)
+                close();
+            else if (cycle >= start_)
+                tfp_->dump(contextp_->time());
+        }
+#endif
+    }
+
+    void close() {
+#if VM_TRACE
+        if (tfp_) {
+            tfp_->close();
+            tfp_.reset();
+        }
+#endif
+    }
+
+private:
+    VerilatedContext* contextp_;
+    uint64_t          start_, stop_;
+#if VM_TRACE_FST
+    std::unique_ptr<VerilatedFstC> tfp_;
+#elif VM_TRACE
+    std::unique_ptr<VerilatedVcdC> tfp_;
+#endif
+};
+
+//-----------------------------------------------------------------------------
+// Clock / stream driver
+//-----------------------------------------------------------------------------
+class AccelDriver {
+public:
+    AccelDriver(VerilatedContext* contextp, Vconv3x3_accel_top* top, Tracer* tracer = nullptr)
+        : contextp_(contextp), top_(top), tracer_(tracer) {
+        top_->clk = 0;
+        top_->rst_n = 0;
+        top_->cfg_valid = 0;
+        top_->start = 0;
+        top_->prm_wr_valid = 0;
+        top_->wgt_in_valid = 0;
+        top_->wgt_in_last = 0;
+        top_->act_in_valid = 0;
+        top_->act_in_last = 0;
+        top_->out_ready = 1;
+        for (int i = 0; i < golden::BUS_W / 32; i++) {
+            top_->wgt_in_data[i] = 0;
+            top_->act_in_data[i] = 0;
+        }
+    }
+
+    uint64_t cycles() const { return cycles_; }
+    bool     out_last_seen() const { return out_lasts_ != 0; }
+    size_t   out_last_count() const { return out_lasts_; }
+
+    // Layers finished (rising edges of done) and the ST_LOAD_WGT cycles of
+    // each, sampled before the next layer clears the counters
+    size_t   layers_done() const { return load_wgt_cycles_.size(); }
+    const std::vector<uint32_t>& load_wgt_cycles() const { return load_wgt_cycles_; }
+
+    // Active-low reset held for n cycles
+    void reset(int n) {
+        top_->rst_n = 0;
+        for (int i = 0; i < n; i++)
+            tick();
+        top_->rst_n = 1;
+    }
+
+    // Present the layer configuration with start until cfg is accepted.
+    // out_bits < 32 selects requantized output (cfg_mode_raw_out = 0); the
+    // default tile streams whole rows.
+    void configure(const golden::LayerConfig& c, const golden::ColumnTile& tile = {}) {
+        set_config(c, tile);
+        top_->start = 1;
+        cfg_fired_ = false;
+        run_until([&] { return cfg_fired_; }, UINT64_MAX);
+        top_->cfg_valid = 0;
+        top_->start = 0;
+    }
+
+    // Present the configuration without start for n cycles; returns whether
+    // it was accepted. While a layer runs it must not be: only a config
+    // with start can be queued.
+    bool offer_config_without_start(const golden::LayerConfig& c, int n) {
+        set_config(c, {});
+        top_->start = 0;
+        cfg_fired_ = false;
+        run_until([&] { return cfg_fired_; }, uint64_t(n));
+        top_->cfg_valid = 0;
+        return cfg_fired_;
+    }
+
+    // Write the per-OC post-op parameters of the next layer to be
+    // configured, one prm_wr handshake per channel
+    void write_post_ops(const golden::PostOps& q, int OC) {
+        for (int oc = 0; oc < OC; oc++) {
+            top_->prm_wr_oc = oc;
+            top_->prm_wr_bias = uint32_t(q.bias[oc]);
+            top_->prm_wr_scale = uint16_t(q.scale[oc]);
+            top_->prm_wr_shift = q.shift[oc];
+            top_->prm_wr_valid = 1;
+            prm_fired_ = false;
+            run_until([&] { return prm_fired_; }, UINT64_MAX);
+        }
+        top_->prm_wr_valid = 0;
+    }
+
+    // Streams are referenced, not copied; beats are BUS_BYTES apart
+    void send_weights(const uint8_t* data, size_t beats)     { wgt_ = {data, beats, 0}; }
+    void send_activations(const uint8_t* data, size_t beats) { act_ = {data, beats, 0}; }
+    size_t weights_sent() const     { return wgt_.sent; }
+    size_t activations_sent() const { return act_.sent; }
+    bool   weights_done() const     { return wgt_.sent == wgt_.beats; }
+    bool   activations_done() const { return act_.sent == act_.beats; }
+
+    // Accepted out_data beats go to the scoreboard. With back-to-back layers
+    // queue one scoreboard per layer; beats move on to the next one once the
+    // current layer's scoreboard is complete.
+    void set_sink(golden::OutputScoreboard* sb) { sinks_.assign(1, sb); }
+    void queue_sink(golden::OutputScoreboard* sb) { sinks_.push_back(sb); }
+
+    // One eval per clock edge, i.e. two per cycle; neither can be dropped:
+    // - Verilator detects posedge clk by comparing with the clk value of
+    //   the previous eval, so the posedge eval needs an eval at clk = 0
+    //   before it
+    // - that clk = 0 eval also settles the combinational paths from the
+    //   inputs drive() just changed (e.g. cfg_ready depends on start), so
+    //   the handshakes sampled below are the ones the posedge will see
+    // The model has no negedge logic, so the clk = 0 eval only settles
+    // combinational logic.
+    void tick() {
+        drive(wgt_, top_->wgt_in_valid, top_->wgt_in_last, top_->wgt_in_data);
+        drive(act_, top_->act_in_valid, top_->act_in_last, top_->act_in_data);
+
+        top_->clk = 0;
+        top_->eval();
+        dump();
+
+        // Handshakes as seen by the coming posedge
+        const bool cfg_fire = top_->cfg_valid && top_->cfg_ready;
+        const bool prm_fire = top_->prm_wr_valid && top_->prm_wr_ready;
+        const bool wgt_fire = top_->wgt_in_valid && top_->wgt_in_ready;
+        const bool act_fire = top_->act_in_valid && top_->act_in_ready;
+        if (top_->out_valid && top_->out_ready) {
+            uint32_t words[golden::OutputScoreboard::LANES];
+            for (int i = 0; i < golden::OutputScoreboard::LANES; i++)
+                words[i] = top_->out_data[i];
+            while (sinks_.size() > 1 && sinks_.front()->complete())
+                sinks_.pop_front();
+            if (!sinks_.empty())
+                sinks_.front()->push_beat(words);
+            out_lasts_ += top_->out_last;
+        }
+
+        top_->clk = 1;
+        top_->eval();
+        dump();
+        cycles_++;
+
+        cfg_fired_ |= cfg_fire;
+        prm_fired_ |= prm_fire;
+        if (top_->done && !done_prev_)
+            load_wgt_cycles_.push_back(top_->perf_cyc_load_wgt);
+        done_prev_ = top_->done;
+        if (wgt_fire) wgt_.sent++;
+        if (act_fire) act_.sent++;
+    }
+
+    // Tick until done() holds or max_cycles elapse; returns done()
+    template <typename Pred>
+    bool run_until(Pred done, uint64_t max_cycles) {
+        for (uint64_t n = 0; n < max_cycles; n++) {
+            if (done())
+                return true;
+            tick();
+        }
+        return done();
+    }
+
+private:
+    // cfg_* ports for layer c (and cfg_valid); start is left to the caller
+    void set_config(const golden::LayerConfig& c, const golden::ColumnTile& tile) {
+        top_->cfg_W = c.W;
+        top_->cfg_H = c.H;
+        top_->cfg_IC = c.IC;
+        top_->cfg_OC = c.OC;
+        top_->cfg_stride = c.stride;
+        top_->cfg_pad = c.pad;
+        top_->cfg_pad_use_code = c.pad_use_code;
+        top_->cfg_pad_code = c.pad_code;
+        top_->cfg_tile_x0 = tile.x0;
+        top_->cfg_tile_W = tile.W;
+        top_->cfg_act_bits = c.act_bits;
+        top_->cfg_wgt_bits = c.wgt_bits;
+        top_->cfg_mode_raw_out = c.out_bits == 32;
+        top_->cfg_out_bits = c.out_bits == 32 ? 0 : c.out_bits;
+        top_->cfg_relu = c.relu;
+        top_->cfg_batch = uint8_t(c.batch);
+        top_->cfg_valid = 1;
+    }
+
+    struct Source {
+        const uint8_t* data  = nullptr;
+        size_t         beats = 0;
+        size_t         sent  = 0;
+    };
+
+    template <typename BitT, typename WideT>
+    static void drive(const Source& s, BitT& valid, BitT& last, WideT& port) {
+        if (s.sent < s.beats) {
+            const uint8_t* beat = s.data + s.sent * golden::BUS_BYTES;
+            for (int i = 0; i < golden::BUS_W / 32; i++) {
+                uint32_t word;
+                memcpy(&word, beat + 4 * i, sizeof(word));
+                port[i] = word;
+            }
+            valid = 1;
+            last  = (s.sent + 1 == s.beats);
+        } else {
+            valid = 0;
+            last  = 0;
+        }
+    }
+
+    void dump() {
+        if (tracer_)
+            tracer_->dump();
+        contextp_->timeInc(1);
+    }
+
+    VerilatedContext*          contextp_;
+    Vconv3x3_accel_top*        top_;
+    Tracer*                    tracer_;
+    Source                     wgt_, act_;
+    std::deque<golden::OutputScoreboard*> sinks_;
+    uint64_t                   cycles_ = 0;
+    bool                       cfg_fired_ = false;
+    bool                       prm_fired_ = false;
+    bool                       done_prev_ = false;
+    std::vector<uint32_t>      load_wgt_cycles_;
+    size_t                     out_lasts_ = 0;
+};
+
+#endif // TB_DRIVER_H
@@ -0,0 +1,595 @@
+//=============================================================================
+// tb_golden_model.cpp - Self-check for the C++ golden model
+//
+// Build & run (no Verilator needed):
+//   g++ -O2 -std=c++17 -o tb_golden_model tb/tb_golden_model.cpp tb/conv3x3_golden*.cpp -pthread
+//   ./tb_golden_model
+//=============================================================================
+
+#include "conv3x3_golden.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <unistd.h>
+#include <vector>
+
+using namespace golden;
+
+static int error_count = 0;
+
+#define CHECK(cond, ...)                            \
+    do {                                            \
+        if (!(cond)) {                              \
+            printf("  FAIL: " __VA_ARGS__);         \
+            printf("\n");                           \
+            error_count++;                          \
+        }                                           \
+    } while (0)
+
+static std::vector<uint8_t> random_stream(size_t elems, int bits) {
+    std::vector<uint8_t> s((elems * bits + BUS_W - 1) / BUS_W * BUS_BYTES);
+    if (bits == 16) {
+        std::vector<uint16_t> codes(elems);
+        for (uint16_t& c : codes) c = uint16_t(rand());
+        pack_codes(codes.data(), elems, s.data());
+    } else {
+        std::vector<uint8_t> codes(elems);
+        for (uint8_t& c : codes) c = uint8_t(rand());
+        pack_codes(codes.data(), elems, bits, s.data());
+    }
+    return s;
+}
+
+// Every pack kernel must produce the stream_put layout, tails included
+static void test_pack() {
+    printf("Test: pack/unpack (best=%s)\n", pack_kernel_name(detect_pack_kernel()));
+    for (int bits : {2, 4, 8}) {
+        for (size_t n : {size_t(0), size_t(1), size_t(7), size_t(31), size_t(33), size_t(200), size_t(1027)}) {
+            std::vector<uint8_t> codes(n);
+            std::vector<uint8_t> ref((n * bits + 7) / 8 + 1, 0);
+            for (size_t i = 0; i < n; i++) {
+                codes[i] = uint8_t(rand());  // high bits must be ignored
+                stream_put(ref.data(), i, bits, codes[i] & ((1u << bits) - 1));
+            }
+            for (PackKernel k : {PackKernel::Scalar, PackKernel::BMI2, PackKernel::AVX2}) {
+                if (int(k) > int(detect_pack_kernel()))
+                    continue;
+                std::vector<uint8_t> got(ref.size(), 0);
+                pack_codes(codes.data(), n, bits, got.data(), k);
+                CHECK(got == ref, "pack %s bits=%d n=%zu", pack_kernel_name(k), bits, n);
+
+                std::vector<uint8_t> back(n);
+                unpack_codes(ref.data(), n, bits, back.data(), k);
+                bool ok = true;
+                for (size_t i = 0; i < n; i++)
+                    ok &= back[i] == (codes[i] & ((1u << bits) - 1));
+                CHECK(ok, "unpack %s bits=%d n=%zu", pack_kernel_name(k), bits, n);
+            }
+        }
+    }
+    std::vector<uint16_t> c16(37), b16(37);
+    std::vector<uint8_t> s16(74), r16(74);
+    for (size_t i = 0; i < c16.size(); i++) {
+        c16[i] = uint16_t(rand());
+        stream_put(r16.data(), i, 16, c16[i]);
+    }
+    pack_codes(c16.data(), c16.size(), s16.data());
+    unpack_codes(s16.data(), c16.size(), b16.data());
+    CHECK(s16 == r16 && b16 == c16, "pack/unpack 16-bit");
+}
+
+// Direct convolution on reconstructed values: sum(A*W) >> 1, wrapped to 32 bits.
+// Border taps of a padded layer are 0 or the reconstructed pad code.
+static std::vector<int32_t> naive_conv(const LayerConfig& c, const uint8_t* act,
+                                       const uint8_t* wgt) {
+    std::vector<int32_t> out(c.out_elements());
+    for (int oy = 0; oy < c.OH(); oy++)
+        for (int ox = 0; ox < c.OW(); ox++)
+            for (int oc = 0; oc < c.OC; oc++) {
+                int64_t sum = 0;
+                for (int kh = 0; kh < KH; kh++)
+                    for (int kw = 0; kw < KW; kw++)
+                        for (int ic = 0; ic < c.IC; ic++) {
+                            int y = oy * c.stride_step() + kh - c.pad;
+                            int x = ox * c.stride_step() + kw - c.pad;
+                            int64_t a;
+                            if (y >= 0 && y < c.H && x >= 0 && x < c.W)
+                                a = reconstruct(stream_get(act, (size_t(y) * c.W + x) * c.IC + ic, c.act_bits), c.act_bits);
+                            else
+                                a = c.pad_use_code ? reconstruct(c.pad_code, c.act_bits) : 0;
+                            int64_t w = reconstruct(stream_get(wgt, ((size_t(kh) * KW + kw) * c.OC + oc) * c.IC + ic, c.wgt_bits), c.wgt_bits);
+                            sum += a * w;
+                        }
+                out[(size_t(oy) * c.OW() + ox) * c.OC + oc] = int32_t(uint32_t(uint64_t(sum >> 1)));
+            }
+    return out;
+}
+
+static void test_element_helpers() {
+    printf("Test: decode2 / reconstruct / muladd2_lut\n");
+    CHECK(decode2(0) == -3 && decode2(1) == -1 && decode2(2) == 1 && decode2(3) == 3, "decode2");
+    CHECK(reconstruct(0x0, 4) == -15, "reconstruct(0x0,4)=%d", reconstruct(0x0, 4));
+    CHECK(reconstruct(0xF, 4) == 15, "reconstruct(0xF,4)=%d", reconstruct(0xF, 4));
+    CHECK(reconstruct(0xFFFF, 16) == 65535, "reconstruct(0xFFFF,16)");
+
+    for (uint32_t in = 0; in < 256; in++) {
+        uint32_t out = muladd2_lut(in & 3, (in >> 2) & 3, (in >> 4) & 3, (in >> 6) & 3);
+        int pair = decode2(in) * decode2(in >> 2) + decode2(in >> 4) * decode2(in >> 6);
+        CHECK(out <= 18 && int(out) * 2 == pair + 18, "muladd2_lut(0x%02x)=%u", in, out);
+    }
+
+    std::vector<uint8_t> s(BUS_BYTES * 2);
+    for (int bits : {2, 4, 8, 16}) {
+        for (size_t i = 0; i < size_t(2 * BUS_W / bits); i++)
+            stream_put(s.data(), i, bits, uint32_t(i * 7 + 3) & ((1u << bits) - 1));
+        for (size_t i = 0; i < size_t(2 * BUS_W / bits); i++)
+            CHECK(stream_get(s.data(), i, bits) == (uint32_t(i * 7 + 3) & ((1u << bits) - 1)),
+                  "stream bits=%d idx=%zu", bits, i);
+    }
+}
+
+static void test_layer(const LayerConfig& c) {
+    printf("Test: W=%d H=%d IC=%d OC=%d stride=%d act_bits=%d wgt_bits=%d pad=%d%s\n",
+           c.W, c.H, c.IC, c.OC, c.stride_step(), c.act_bits, c.wgt_bits, c.pad,
+           c.pad && c.pad_use_code ? " (code)" : "");
+    std::vector<uint8_t> act = random_stream(c.act_elements(), c.act_bits);
+    std::vector<uint8_t> wgt = random_stream(c.wgt_elements(), c.wgt_bits);
+
+    ConvGolden model(c, act.data(), wgt.data(), Kernel::Reference);
+    std::vector<int32_t> got = model.compute();
+    std::vector<int32_t> exp = naive_conv(c, act.data(), wgt.data());
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < exp.size(); i++)
+        if (got[i] != exp[i] && mismatches++ < 5)
+            printf("  FAIL: idx %zu golden=%d naive=%d\n", i, got[i], exp[i]);
+    if (mismatches) error_count++;
+}
+
+// Every packed 2b x 2b kernel must be bit-identical to the reference path
+static void test_kernels(const LayerConfig& c) {
+    printf("Test: kernels W=%d H=%d IC=%d OC=%d stride=%d pad=%d (best=%s)\n",
+           c.W, c.H, c.IC, c.OC, c.stride_step(), c.pad, kernel_name(detect_kernel()));
+    std::vector<uint8_t> act = random_stream(c.act_elements(), 2);
+    std::vector<uint8_t> wgt = random_stream(c.wgt_elements(), 2);
+    std::vector<int32_t> ref = ConvGolden(c, act.data(), wgt.data(), Kernel::Reference).compute();
+
+    for (Kernel k : {Kernel::Scalar, Kernel::AVX2, Kernel::AVX512}) {
+        if (int(k) > int(detect_kernel()))
+            continue;
+        std::vector<int32_t> got = ConvGolden(c, act.data(), wgt.data(), k).compute();
+        CHECK(got == ref, "kernel %s differs from reference", kernel_name(k));
+    }
+}
+
+// Threaded evaluation must match the single-threaded path for any split
+static void test_parallel(const LayerConfig& c, Kernel k) {
+    printf("Test: parallel W=%d H=%d IC=%d OC=%d act_bits=%d wgt_bits=%d kernel=%s\n",
+           c.W, c.H, c.IC, c.OC, c.act_bits, c.wgt_bits, kernel_name(k));
+    std::vector<uint8_t> act = random_stream(c.act_elements(), c.act_bits);
+    std::vector<uint8_t> wgt = random_stream(c.wgt_elements(), c.wgt_bits);
+    ConvGolden model(c, act.data(), wgt.data(), k);
+    std::vector<int32_t> ref = model.compute();
+
+    for (unsigned threads : {1u, 3u, 8u}) {
+        ParallelGolden pool(model, threads);
+        // Consume rows in order as a streaming checker would
+        bool rows_ok = true;
+        for (int oy = 0; oy < c.OH(); oy++) {
+            const int32_t* row = pool.wait_row(oy);
+            for (size_t i = 0; i < size_t(c.OW()) * c.OC; i++)
+                rows_ok &= row[i] == ref[size_t(oy) * c.OW() * c.OC + i];
+        }
+        CHECK(rows_ok && pool.wait_all() == ref, "%u threads differ from single-threaded", threads);
+    }
+}
+
+// Feed the expected stream back as beats, then a corrupted copy
+static void test_scoreboard(const LayerConfig& c, bool with_pool) {
+    printf("Test: scoreboard W=%d H=%d IC=%d OC=%d act_bits=%d wgt_bits=%d pool=%d\n",
+           c.W, c.H, c.IC, c.OC, c.act_bits, c.wgt_bits, int(with_pool));
+    std::vector<uint8_t> act = random_stream(c.act_elements(), c.act_bits);
+    std::vector<uint8_t> wgt = random_stream(c.wgt_elements(), c.wgt_bits);
+    ConvGolden model(c, act.data(), wgt.data());
+    std::vector<int32_t> ref = model.compute();
+    const size_t beats = (ref.size() + OutputScoreboard::LANES - 1) / OutputScoreboard::LANES;
+    ref.resize(beats * OutputScoreboard::LANES, 0x5A5A5A5A);  // padding must be ignored
+
+    auto run = [&](const std::vector<int32_t>& stream, size_t nbeats,
+                   std::unique_ptr<OutputScoreboard>& sb, std::unique_ptr<ParallelGolden>& pool) {
+        pool.reset(with_pool ? new ParallelGolden(model, 2) : nullptr);
+        sb.reset(new OutputScoreboard(model, pool.get()));
+        for (size_t b = 0; b < nbeats; b++)
+            if (!sb->push_beat(reinterpret_cast<const uint32_t*>(&stream[b * OutputScoreboard::LANES])))
+                break;
+    };
+    std::unique_ptr<ParallelGolden> pool;
+    std::unique_ptr<OutputScoreboard> sb;
+
+    run(ref, beats, sb, pool);
+    CHECK(sb->complete() && sb->checked() == c.out_elements(), "clean stream not accepted");
+
+    run(ref, beats - 1, sb, pool);
+    CHECK(!sb->complete() && !sb->failed(), "short stream reported complete");
+
+    // Flip one element in the middle; checking must stop exactly there
+    const size_t bad = c.out_elements() / 2 + 1;
+    std::vector<int32_t> corrupt = ref;
+    corrupt[bad] ^= 1;
+    run(corrupt, beats, sb, pool);
+    const OutputScoreboard::Mismatch& m = sb->mismatch();
+    CHECK(sb->failed() && m.index == bad && sb->checked() == bad, "mismatch index %zu", m.index);
+    CHECK(m.oc == int(bad % c.OC) && m.ox == int(bad / c.OC % c.OW()) &&
+          m.oy == int(bad / (size_t(c.OC) * c.OW())), "mismatch coordinates");
+    CHECK(m.got == (ref[bad] ^ 1) && m.expected == ref[bad], "mismatch values");
+
+    // One beat too many
+    std::vector<int32_t> extra = ref;
+    extra.resize(ref.size() + OutputScoreboard::LANES, 0);
+    run(extra, beats + 1, sb, pool);
+    CHECK(sb->failed() && sb->mismatch().oy == -1, "extra beat not reported");
+}
+
+// Column tiles must cover every output column once, every tap of a tile's
+// windows must be in the tile (or the border), and a tile's output block,
+// computed from the tile stream alone as feature_line_buffer addresses it,
+// must match the whole-layer columns; the scoreboard checks it in place
+static void test_column_tiles(const LayerConfig& c, int max_cols) {
+    printf("Test: column tiles W=%d stride=%d pad=%d max_cols=%d\n",
+           c.W, c.stride_step(), c.pad, max_cols);
+    std::vector<uint8_t> act = random_stream(c.act_elements(), c.act_bits);
+    std::vector<uint8_t> wgt = random_stream(c.wgt_elements(), c.wgt_bits);
+    const std::vector<int32_t> ref = naive_conv(c, act.data(), wgt.data());
+    ConvGolden model(c, act.data(), wgt.data());
+
+    int next_ox = 0;
+    for (const ColumnTile& t : column_tiles(c, max_cols)) {
+        const int cols = t.cols(c), ox0 = t.ox0(c), OW = t.OW(c);
+        CHECK(cols <= std::max(max_cols, KW) || t.W == 0, "tile x0=%d too wide", t.x0);
+        CHECK(ox0 == next_ox && OW > 0, "tile x0=%d: ox0=%d OW=%d, expected ox0=%d",
+              t.x0, ox0, OW, next_ox);
+        next_ox = ox0 + OW;
+
+        std::vector<uint8_t> ts(t.act_beats(c) * BUS_BYTES);
+        extract_tile(c, t, act.data(), ts.data());
+        std::vector<int32_t> block;
+        bool taps_in_tile = true;
+        for (int oy = 0; oy < c.OH(); oy++)
+            for (int ox = ox0; ox < ox0 + OW; ox++)
+                for (int oc = 0; oc < c.OC; oc++) {
+                    int64_t sum = 0;
+                    for (int kh = 0; kh < KH; kh++)
+                        for (int kw = 0; kw < KW; kw++)
+                            for (int ic = 0; ic < c.IC; ic++) {
+                                int y = oy * c.stride_step() + kh - c.pad;
+                                int x = ox * c.stride_step() + kw - c.pad;
+                                int64_t a = 0;
+                                if (y >= 0 && y < c.H && x >= 0 && x < c.W) {
+                                    taps_in_tile &= x >= t.x0 && x < t.x0 + cols;
+                                    a = reconstruct(stream_get(ts.data(), (size_t(y) * cols + x - t.x0) * c.IC + ic,
+                                                               c.act_bits), c.act_bits);
+                                }
+                                int64_t w = reconstruct(stream_get(wgt.data(), ((size_t(kh) * KW + kw) * c.OC + oc) * c.IC + ic,
+                                                                   c.wgt_bits), c.wgt_bits);
+                                sum += a * w;
+                            }
+                    block.push_back(int32_t(uint32_t(uint64_t(sum >> 1))));
+                }
+        CHECK(taps_in_tile, "tile x0=%d: window tap outside the tile", t.x0);
+        bool match = true;
+        for (size_t i = 0; i < block.size(); i++) {
+            const size_t pixel = i / c.OC;
+            const size_t oy = pixel / OW, ox = ox0 + pixel % OW;
+            match &= block[i] == ref[(oy * c.OW() + ox) * c.OC + i % c.OC];
+        }
+        CHECK(match, "tile x0=%d: output block differs from the layer", t.x0);
+
+        OutputScoreboard sb(model);
+        sb.set_columns(ox0, OW);
+        block.resize((block.size() + OutputScoreboard::LANES - 1) / OutputScoreboard::LANES *
+                     OutputScoreboard::LANES, 0);
+        for (size_t b = 0; b < block.size(); b += OutputScoreboard::LANES)
+            sb.push_beat(reinterpret_cast<const uint32_t*>(&block[b]));
+        CHECK(sb.complete() && sb.checked() == t.out_elements(c), "tile x0=%d: scoreboard", t.x0);
+    }
+    CHECK(next_ox == c.OW(), "tiles cover %d of %d output columns", next_ox, c.OW());
+}
+
+// Post-op codes must reconstruct to t on the odd grid, clamped at the code
+// range (at zero with ReLU), BN folding must match the float BatchNorm, and
+// a post-op scoreboard must accept the packed stream
+static void test_post_ops() {
+    printf("Test: post_op / fold_batchnorm / post-op scoreboard\n");
+    CHECK(post_op(0, 0, 1, 0, false, 2) == 1 && post_op(1, 0, 1, 0, false, 2) == 2, "post_op(0|1)");
+    CHECK(post_op(-100, 0, 1, 0, false, 4) == 0 && post_op(100, 0, 1, 0, false, 4) == 15, "post_op clamp");
+    CHECK(post_op(5, 0, 3, 1, false, 8) == 131, "post_op((5*3+1)>>1)=%u", post_op(5, 0, 3, 1, false, 8));
+    CHECK(post_op(2, 4, 3, 1, false, 8) == 132, "post_op(((2+4)*3+1)>>1)=%u", post_op(2, 4, 3, 1, false, 8));
+    CHECK(post_op(-9, 0, 1, 0, true, 4) == 7, "post_op relu=%u", post_op(-9, 0, 1, 0, true, 4));
+    CHECK(post_op(INT32_MAX, INT32_MAX, 2, 0, false, 16) == 65535, "post_op sum overflow");
+    for (int bits : {2, 4, 8, 16}) {
+        const int32_t vmax = (1 << bits) - 1;
+        for (int i = 0; i < 2000; i++) {
+            const int32_t acc   = rand() % 200001 - 100000;
+            const int32_t bias  = rand() % 2001 - 1000;
+            const int     scale = int16_t(rand());
+            const int     shift = rand() % 32;
+            const bool    relu  = rand() & 1;
+            int64_t t = (int64_t(acc) + bias) * scale;
+            if (shift) t += int64_t(1) << (shift - 1);
+            t >>= shift;
+            if (relu && t < 0) t = 0;
+            const int32_t v = reconstruct(post_op(acc, bias, scale, shift, relu, bits), bits);
+            const bool ok = t < -vmax ? v == -vmax :
+                            t > vmax  ? v == vmax  :
+                            (v == t || v == t - 1) && (v & 1);
+            CHECK(ok, "post_op(%d,%d,%d,%d,%d,%d): t=%lld v=%d", acc, bias, scale, shift,
+                  int(relu), bits, (long long)t, v);
+            if (!ok)
+                break;
+        }
+    }
+
+    // Folded parameters against the float BatchNorm, within one output step
+    // (plus the fixed-point error of scale)
+    for (int i = 0; i < 200; i++) {
+        const double gamma = (rand() % 2000 - 1000) / 250.0;
+        const double beta  = (rand() % 2000 - 1000) / 10.0;
+        const double mean  = (rand() % 2000 - 1000) / 2.0;
+        const double var   = (rand() % 1000 + 1) * 4.0;
+        const double step  = 0.5 + rand() % 8;
+        if (gamma == 0.0)
+            continue;  // constant channel, not expressible (see fold_batchnorm)
+        int32_t bias; int16_t scale; uint8_t shift;
+        fold_batchnorm(gamma, beta, mean, var, 1e-5, step, &bias, &scale, &shift);
+        for (int32_t x : {-5000, -300, 0, 77, 4000}) {
+            const double y   = (gamma * (x - mean) / std::sqrt(var + 1e-5) + beta) / step;
+            const double got = double(((int64_t(x) + bias) * scale + (shift ? int64_t(1) << (shift - 1) : 0)) >> shift);
+            const double tol = 1.5 + std::fabs(y) / 16384.0;
+            CHECK(std::fabs(got - y) <= tol, "fold_batchnorm g=%g b=%g m=%g v=%g x=%d: %g vs %g",
+                  gamma, beta, mean, var, x, got, y);
+        }
+    }
+
+    for (int bits : {2, 4, 8, 16}) {
+        LayerConfig c{7, 6, 16, 32, 0, 2, 2};
+        c.out_bits = bits;
+        c.relu = bits == 4;
+        std::vector<uint8_t> act = random_stream(c.act_elements(), c.act_bits);
+        std::vector<uint8_t> wgt = random_stream(c.wgt_elements(), c.wgt_bits);
+        ConvGolden model(c, act.data(), wgt.data());
+        std::vector<int32_t> ref = model.compute();
+        PostOps ops;
+        for (int oc = 0; oc < c.OC; oc++) {
+            ops.bias.push_back(rand() % 201 - 100);
+            ops.scale.push_back(int16_t(1 + rand() % 255));
+            ops.shift.push_back(uint8_t(4 + rand() % 8));
+        }
+        std::vector<uint8_t> stream(c.out_beats() * BUS_BYTES, 0);
+        for (size_t i = 0; i < ref.size(); i++)
+            stream_put(stream.data(), i, bits, ops.apply(ref[i], int(i % c.OC), c.relu, bits));
+        OutputScoreboard sb(model);
+        sb.set_post_ops(&ops);
+        for (size_t b = 0; b < c.out_beats(); b++)
+            sb.push_beat(reinterpret_cast<const uint32_t*>(&stream[b * BUS_BYTES]));
+        CHECK(sb.complete(), "out_bits=%d stream not accepted (checked %zu)", bits, sb.checked());
+    }
+
+    // Raw outputs with ReLU: negative sums read 0, nothing else changes
+    {
+        LayerConfig c{7, 6, 16, 32, 0, 2, 2};
+        c.relu = true;
+        std::vector<uint8_t> act = random_stream(c.act_elements(), c.act_bits);
+        std::vector<uint8_t> wgt = random_stream(c.wgt_elements(), c.wgt_bits);
+        ConvGolden model(c, act.data(), wgt.data());
+        std::vector<int32_t> ref = model.compute();
+        size_t neg = 0;
+        for (int32_t& v : ref) {
+            neg += v < 0;
+            v = std::max(v, 0);
+        }
+        ref.resize((ref.size() + OutputScoreboard::LANES - 1) / OutputScoreboard::LANES *
+                   OutputScoreboard::LANES, 0);
+        OutputScoreboard sb(model);
+        for (size_t b = 0; b < ref.size(); b += OutputScoreboard::LANES)
+            sb.push_beat(reinterpret_cast<const uint32_t*>(&ref[b]));
+        CHECK(sb.complete(), "raw ReLU stream not accepted (checked %zu)", sb.checked());
+        CHECK(neg > 0, "raw ReLU layer has no negative sums");
+    }
+}
+
+// Write a layer, map it back and check every section byte for byte
+static void test_tensor_file(const LayerConfig& c, bool with_output) {
+    printf("Test: tensor file W=%d H=%d IC=%d OC=%d act_bits=%d wgt_bits=%d output=%d\n",
+           c.W, c.H, c.IC, c.OC, c.act_bits, c.wgt_bits, int(with_output));
+    const char* path = "tb_golden_model_tmp.tns";
+    std::vector<uint8_t> act = random_stream(c.act_elements(), c.act_bits);
+    std::vector<uint8_t> wgt = random_stream(c.wgt_elements(), c.wgt_bits);
+    std::vector<int32_t> out = ConvGolden(c, act.data(), wgt.data()).compute();
+
+    const char* err = write_tensor_file(path, c, wgt.data(), act.data(),
+                                        with_output ? out.data() : nullptr);
+    CHECK(!err, "write_tensor_file: %s", err);
+
+    TensorFile f;
+    err = f.open(path);
+    CHECK(!err, "TensorFile::open: %s", err);
+    if (!err) {
+        const LayerConfig& r = f.config();
+        CHECK(r.W == c.W && r.H == c.H && r.IC == c.IC && r.OC == c.OC && r.stride == c.stride &&
+              r.act_bits == c.act_bits && r.wgt_bits == c.wgt_bits && r.pad == c.pad &&
+              r.pad_use_code == c.pad_use_code && r.pad_code == c.pad_code, "header fields");
+        CHECK(uintptr_t(f.wgt_stream()) % TENSOR_FILE_ALIGN == 0 &&
+              uintptr_t(f.act_stream()) % TENSOR_FILE_ALIGN == 0, "sections not page aligned");
+        CHECK(!memcmp(f.wgt_stream(), wgt.data(), wgt.size()), "weight section");
+        CHECK(!memcmp(f.act_stream(), act.data(), act.size()), "activation section");
+        CHECK(f.has_output() == with_output, "has_output");
+        if (with_output && f.has_output()) {
+            CHECK(!memcmp(f.output(), out.data(), out.size() * sizeof(int32_t)), "output section");
+            // The mapped expected stream drives the scoreboard directly
+            OutputScoreboard sb(f.config(), f.output());
+            for (size_t b = 0; b * OutputScoreboard::LANES < out.size(); b++)
+                sb.push_beat(reinterpret_cast<const uint32_t*>(f.output()) + b * OutputScoreboard::LANES);
+            CHECK(sb.complete(), "scoreboard on mapped output");
+        }
+    }
+    f.close();
+
+    // A truncated file must be rejected, not read past its end
+    if (FILE* fp = fopen(path, "r+b")) {
+        fclose(fp);
+        CHECK(truncate(path, TENSOR_FILE_ALIGN + 16) == 0, "truncate");
+        CHECK(f.open(path) != nullptr, "truncated file accepted");
+    }
+    remove(path);
+}
+
+// Packing a 256x256x256 2-bit activation tensor (informational)
+static void bench_pack() {
+    const size_t n = size_t(256) * 256 * 256;
+    std::vector<uint8_t> codes(n), stream(n / 4);
+    for (size_t i = 0; i < n; i++)
+        codes[i] = uint8_t(i * 2654435761u >> 24);
+    printf("Bench: pack %zu M 2-bit codes\n", n >> 20);
+    for (PackKernel k : {PackKernel::Scalar, PackKernel::BMI2, PackKernel::AVX2}) {
+        if (int(k) > int(detect_pack_kernel()))
+            continue;
+        auto t0 = std::chrono::steady_clock::now();
+        pack_codes(codes.data(), n, 2, stream.data(), k);
+        double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        printf("  %-9s %8.4f s  %8.2f GB/s in\n", pack_kernel_name(k), sec, n / sec / 1e9);
+    }
+}
+
+// Throughput of each kernel on a wide layer (informational)
+static void bench_kernels() {
+    LayerConfig c{34, 10, 256, 256, 0, 2, 2};
+    std::vector<uint8_t> act = random_stream(c.act_elements(), 2);
+    std::vector<uint8_t> wgt = random_stream(c.wgt_elements(), 2);
+    double macs = double(c.out_elements()) * KH * KW * c.IC;
+
+    printf("Bench: W=%d H=%d IC=%d OC=%d, %.1f M 2-bit MACs\n", c.W, c.H, c.IC, c.OC, macs / 1e6);
+    for (Kernel k : {Kernel::Reference, Kernel::Scalar, Kernel::AVX2, Kernel::AVX512}) {
+        if (int(k) > int(detect_kernel()))
+            continue;
+        ConvGolden model(c, act.data(), wgt.data(), k);
+        auto t0 = std::chrono::steady_clock::now();
+        std::vector<int32_t> out = model.compute();
+        double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        printf("  %-9s %8.3f s  %8.2f GMAC/s\n", kernel_name(k), sec, macs / sec / 1e9);
+    }
+
+    ConvGolden model(c, act.data(), wgt.data());
+    auto t0 = std::chrono::steady_clock::now();
+    ParallelGolden pool(model);
+    pool.wait_all();
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    printf("  %-9s %8.3f s  %8.2f GMAC/s  (%u threads)\n", kernel_name(model.kernel()), sec,
+           macs / sec / 1e9, pool.threads());
+}
+
+int main() {
+    printf("========================================\n");
+    printf(" Golden Model Self-Check\n");
+    printf("========================================\n");
+    srand(1);
+
+    test_element_helpers();
+    test_pack();
+
+    const LayerConfig layers[] = {
+        // W  H  IC  OC  stride act wgt
+        {8, 8, 16, 16, 0, 2, 2},
+        {8, 8, 16, 16, 1, 2, 2},
+        {8, 8, 32, 16, 0, 4, 2},
+        {8, 8, 16, 32, 0, 2, 4},
+        {7, 5, 16, 16, 0, 8, 2},
+        {5, 7, 16, 16, 1, 2, 16},
+        {6, 6, 32, 32, 0, 4, 4},
+        {5, 5, 16, 16, 0, 16, 16},
+    };
+    for (const LayerConfig& c : layers)
+        test_layer(c);
+    CHECK(LayerConfig({6, 6, 32, 32, 0, 4, 4}).validate() == nullptr &&
+          LayerConfig({5, 5, 16, 16, 0, 16, 16}).validate() == nullptr,
+          "act_bits>2 && wgt_bits>2 rejected");
+    {
+        LayerConfig c{8, 8, 16, 16, 0, 2, 2};
+        c.batch = 8;
+        bool ok = c.validate() == nullptr;
+        c.batch = 0;
+        ok &= c.validate() != nullptr;
+        c.batch = 256;
+        ok &= c.validate() != nullptr;
+        CHECK(ok, "cfg_batch range");
+    }
+    {
+        // MAX_W bounds the column tile, not the layer
+        LayerConfig c{600, 3, 16, 16, 0, 2, 2};
+        CHECK(c.validate() != nullptr && c.validate(256) == nullptr &&
+              c.validate(257) != nullptr, "W > MAX_W with column tiles");
+    }
+
+    // Same padding: zero border, then a pad code (0b10.. = +1 per slice)
+    for (LayerConfig c : layers) {
+        c.pad = 1;
+        test_layer(c);
+        c.pad_use_code = true;
+        c.pad_code     = 0xAAAAu & ((1u << c.act_bits) - 1);
+        test_layer(c);
+    }
+    test_layer([] { LayerConfig c{2, 1, 16, 16, 1, 2, 2}; c.pad = 1; return c; }());
+
+    const LayerConfig kernel_layers[] = {
+        {8, 8, 16, 16, 0, 2, 2},
+        {9, 7, 48, 32, 1, 2, 2},
+        {6, 5, 256, 64, 0, 2, 2},
+    };
+    for (const LayerConfig& c : kernel_layers)
+        test_kernels(c);
+    for (LayerConfig c : kernel_layers) {
+        c.pad = 1;
+        test_kernels(c);
+        c.pad_use_code = true;
+        c.pad_code     = 1;
+        test_kernels(c);
+    }
+
+    test_parallel({10, 9, 32, 64, 0, 2, 2}, detect_kernel());
+    test_parallel({7, 6, 16, 32, 1, 2, 4}, Kernel::Reference);
+
+    test_scoreboard({9, 8, 16, 48, 0, 2, 2}, false);
+    test_scoreboard({7, 7, 32, 16, 1, 4, 2}, true);
+
+    test_column_tiles({40, 5, 16, 16, 0, 2, 2}, 8);
+    test_column_tiles({41, 5, 16, 16, 1, 2, 2}, 9);
+    test_column_tiles([] { LayerConfig c{40, 5, 16, 16, 0, 4, 2}; c.pad = 1; return c; }(), 3);
+    test_column_tiles([] { LayerConfig c{39, 6, 16, 16, 1, 2, 2}; c.pad = 1; return c; }(), 4);
+    test_column_tiles({12, 4, 16, 16, 0, 2, 2}, 64);
+    test_column_tiles([] { LayerConfig c{600, 3, 16, 16, 1, 2, 2}; c.pad = 1; return c; }(), 256);
+
+    test_post_ops();
+
+    test_tensor_file({9, 8, 16, 48, 0, 2, 2}, true);
+    test_tensor_file({8, 6, 32, 16, 1, 4, 8}, false);
+    {
+        LayerConfig c{7, 5, 16, 16, 0, 2, 2};
+        c.pad = 1;
+        c.pad_use_code = true;
+        c.pad_code = 2;
+        test_tensor_file(c, true);
+    }
+
+    bench_pack();
+    bench_kernels();
+
+    printf("========================================\n");
+    if (error_count == 0)
+        printf("✅ ALL GOLDEN MODEL TESTS PASSED\n");
+    else
+        printf("❌ FAILED: %d errors\n", error_count);
+    printf("========================================\n");
+    return error_count ? 1 : 0;
+}
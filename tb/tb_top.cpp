@@ -2,230 +2,477 @@
 // tb_top.cpp - Verilator testbench for conv3x3_accel_top
 //=============================================================================
 
-#include <verilated.h>
-#include <verilated_vcd_c.h>
-#include "Vconv3x3_accel_top.h"
+#include "tb_driver.h"
+#include <chrono>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <ctime>
+#include <memory>
+#include <string>
+#include <vector>
 
-vluint64_t main_time = 0;
+//-----------------------------------------------------------------------------
+// Command line options (Verilator's own +verilator+ args are left alone)
+//
+//   --trace                 enable waveform dump (needs a --trace/--trace-fst build)
+//   --trace-file=NAME       default waveform.fst / waveform.vcd
+//   --trace-start=CYCLE     first clock cycle dumped (default 0)
+//   --trace-stop=CYCLE      last clock cycle dumped, file closed after it
+//   --trace-scope=NAME      only dump this instance, e.g. u_conv_core_lowbit
+//   --trace-depth=N         levels below the top / scope (default 99)
+//   --golden-threads=N      precompute expected outputs on N threads
+//   --stimulus=FILE         replay a tensor file (layer, streams and, if
+//                           present, expected outputs) instead of rand()
+//   --save-stimulus=FILE    write the generated layer and golden outputs
+//   --layers=N              run N layers back to back (same shape, new
+//                           streams each); layer i+1 is queued while layer
+//                           i runs so its weights load during the conv
+//   --out-bits=N            post-process outputs to N-bit codes (2/4/8/16)
+//                           with random per-OC bias/scale/shift; default raw
+//   --relu                  ReLU in the post-ops; raw outputs clamp at 0
+//   --act-bits=N            activation / weight bits of the generated
+//   --wgt-bits=N            layer (2/4/8/16, default 2)
+//   --pad                   same padding, zero border (OH = H / stride)
+//   --pad-code=N            same padding with border taps set to code N
+//   --batch=N               N images per layer against one weight load
+//                           (cfg_batch); one scoreboard per image
+//   --tile-cols=N           run each layer as column tiles of at most N
+//                           input columns (cfg_tile_x0 / cfg_tile_W), one
+//                           queued run per tile
+//   --width=N               W of the generated layer (default 8); above
+//                           MAX_W (256) it needs --tile-cols=N <= 256
+//-----------------------------------------------------------------------------
+struct Options {
+    TraceOptions trace;
+    unsigned     golden_threads = 0;
+    unsigned     layers = 1;
+    unsigned     batch = 1;
+    int          tile_cols = 0;     // 0: whole rows
+    int          width = 8;
+    int          out_bits = 32;
+    int          act_bits = 2;
+    int          wgt_bits = 2;
+    bool         relu = false;
+    bool         pad = false;
+    long         pad_code = -1;     // < 0: zero border
+    std::string  stimulus;
+    std::string  save_stimulus;
+};
 
-double sc_time_stamp() {
-    return main_time;
+static bool match_opt(const char* arg, const char* name, const char** value) {
+    size_t n = strlen(name);
+    if (strncmp(arg, name, n) != 0 || arg[n] != '=')
+        return false;
+    *value = arg + n + 1;
+    return true;
 }
 
-// decode2 function from AGENTS.md
-int decode2(int code) {
-    switch (code & 0x3) {
-        case 0: return -3;
-        case 1: return -1;
-        case 2: return 1;
-        case 3: return 3;
+static Options parse_options(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; i++) {
+        const char* v;
+        if (!strcmp(argv[i], "--trace")) {
+            opt.trace.enable = true;
+        } else if (!strcmp(argv[i], "--relu")) {
+            opt.relu = true;
+        } else if (!strcmp(argv[i], "--pad")) {
+            opt.pad = true;
+        } else if (match_opt(argv[i], "--pad-code", &v)) {
+            opt.pad = true;
+            opt.pad_code = strtol(v, nullptr, 0);
+        } else if (match_opt(argv[i], "--trace-file", &v)) {
+            opt.trace.enable = true;
+            opt.trace.file = v;
+        } else if (match_opt(argv[i], "--trace-start", &v)) {
+            opt.trace.enable = true;
+            opt.trace.start = strtoull(v, nullptr, 0);
+        } else if (match_opt(argv[i], "--trace-stop", &v)) {
+            opt.trace.enable = true;
+            opt.trace.stop = strtoull(v, nullptr, 0);
+        } else if (match_opt(argv[i], "--trace-scope", &v)) {
+            opt.trace.enable = true;
+            opt.trace.scope = v;
+        } else if (match_opt(argv[i], "--trace-depth", &v)) {
+            opt.trace.depth = atoi(v);
+        } else if (match_opt(argv[i], "--golden-threads", &v)) {
+            opt.golden_threads = unsigned(atoi(v));
+        } else if (match_opt(argv[i], "--stimulus", &v)) {
+            opt.stimulus = v;
+        } else if (match_opt(argv[i], "--save-stimulus", &v)) {
+            opt.save_stimulus = v;
+        } else if (match_opt(argv[i], "--layers", &v)) {
+            opt.layers = unsigned(atoi(v)) ? unsigned(atoi(v)) : 1;
+        } else if (match_opt(argv[i], "--batch", &v)) {
+            opt.batch = unsigned(atoi(v)) ? unsigned(atoi(v)) : 1;
+        } else if (match_opt(argv[i], "--tile-cols", &v)) {
+            opt.tile_cols = atoi(v);
+        } else if (match_opt(argv[i], "--width", &v)) {
+            opt.width = atoi(v);
+        } else if (match_opt(argv[i], "--out-bits", &v)) {
+            opt.out_bits = atoi(v);
+        } else if (match_opt(argv[i], "--act-bits", &v)) {
+            opt.act_bits = atoi(v);
+        } else if (match_opt(argv[i], "--wgt-bits", &v)) {
+            opt.wgt_bits = atoi(v);
+        }
     }
-    return 0;
+    return opt;
+}
+
+// Fill a packed bus stream with random element codes
+static std::vector<uint8_t> random_stream(size_t elems, size_t beats, int bits) {
+    std::vector<uint8_t> s(beats * golden::BUS_BYTES, 0);
+    if (bits == 16) {
+        std::vector<uint16_t> codes(elems);
+        for (uint16_t& c : codes) c = uint16_t(rand());
+        golden::pack_codes(codes.data(), elems, s.data());
+    } else {
+        std::vector<uint8_t> codes(elems);
+        for (uint8_t& c : codes) c = uint8_t(rand());
+        golden::pack_codes(codes.data(), elems, bits, s.data());
+    }
+    return s;
+}
+
+// Utilization breakdown from the top-level performance counters
+static void print_perf(const Vconv3x3_accel_top* top, const golden::LayerConfig& layer, int OW) {
+    const double total = top->perf_cyc_total ? double(top->perf_cyc_total) : 1.0;
+    const double conv  = top->perf_cyc_conv ? double(top->perf_cyc_conv) : 1.0;
+    auto pct = [](double n, double d) { return 100.0 * n / d; };
+    
+    // The core accepts one (oy, ox, oc_grp, ic_grp) window per cycle at
+    // peak; OW is that of the last run's column tile
+    const uint64_t ideal = uint64_t(layer.batch) * layer.OH() * OW * layer.num_oc_grp() * layer.num_ic_grp();
+    
+    printf("Performance counters:\n");
+    printf("  total cycles     %10u\n", top->perf_cyc_total);
+    printf("  ST_LOAD_WGT      %10u  %5.1f%% of total\n", top->perf_cyc_load_wgt, pct(top->perf_cyc_load_wgt, total));
+    printf("  ST_LOAD_ACT_CONV %10u  %5.1f%% of total\n", top->perf_cyc_conv, pct(top->perf_cyc_conv, total));
+    printf("  ST_DRAIN_OUT     %10u  %5.1f%% of total\n", top->perf_cyc_drain, pct(top->perf_cyc_drain, total));
+    printf("  core fire        %10u  %5.1f%% of conv, %5.1f%% of total (ideal %llu)\n",
+           top->perf_core_fire, pct(top->perf_core_fire, conv), pct(top->perf_core_fire, total),
+           (unsigned long long)ideal);
+    printf("  core fire burst  %10u  longest back-to-back run\n", top->perf_core_burst);
+    printf("  stall: window    %10u  %5.1f%% of conv\n", top->perf_stall_win, pct(top->perf_stall_win, conv));
+    printf("  stall: weights   %10u  %5.1f%% of conv\n", top->perf_stall_wgt, pct(top->perf_stall_wgt, conv));
+    printf("  stall: stub      %10u  %5.1f%% of total\n", top->perf_stall_stub, pct(top->perf_stall_stub, total));
+    printf("  stall: out_ready %10u  %5.1f%% of total\n", top->perf_stall_out, pct(top->perf_stall_out, total));
 }
 
 int main(int argc, char** argv) {
-    Verilated::commandArgs(argc, argv);
-    Verilated::traceEverOn(true);
+    // All model access stays on this thread; with a --threads N build the
+    // model evaluates on its own worker pool inside eval(). Simulation time
+    // lives in the context rather than a global sc_time_stamp().
+    const std::unique_ptr<VerilatedContext> contextp{new VerilatedContext};
+    contextp->commandArgs(argc, argv);
+    const Options opt = parse_options(argc, argv);
+    contextp->traceEverOn(opt.trace.enable);
     
-    Vconv3x3_accel_top* top = new Vconv3x3_accel_top;
+    Vconv3x3_accel_top* top = new Vconv3x3_accel_top{contextp.get()};
     
-    // Enable tracing
-    VerilatedVcdC* tfp = new VerilatedVcdC;
-    top->trace(tfp, 99);
-    tfp->open("waveform.vcd");
+    // Waveforms are off unless --trace (or a --trace-* option) is given
+    Tracer tracer(contextp.get(), top, opt.trace);
+    AccelDriver drv(contextp.get(), top, &tracer);
     
     printf("========================================\n");
     printf(" Conv3x3 Accelerator Top-Level Test\n");
     printf("========================================\n");
+    printf("Model threads: %u\n", contextp->threads());
     
-    // Reset
-    top->rst_n = 0;
-    top->clk = 0;
-    
-    // Initialize inputs
-    top->cfg_valid = 0;
-    top->cfg_W = 0;
-    top->cfg_H = 0;
-    top->cfg_IC = 0;
-    top->cfg_OC = 0;
-    top->cfg_stride = 0;
-    top->cfg_act_bits = 0;
-    top->cfg_wgt_bits = 0;
-    top->cfg_mode_raw_out = 0;
-    top->start = 0;
-    top->wgt_in_valid = 0;
-    top->wgt_in_last = 0;
-    top->act_in_valid = 0;
-    top->act_in_last = 0;
-    top->out_ready = 1;
-    
-    // Initialize wide data signals
-    for (int i = 0; i < 4; i++) {
-        top->wgt_in_data[i] = 0;
-        top->act_in_data[i] = 0;
-    }
-    
-    // Run reset for 10 cycles
-    for (int i = 0; i < 20; i++) {
-        top->clk = !top->clk;
-        top->eval();
-        tfp->dump(main_time);
-        main_time++;
-    }
-    top->rst_n = 1;
+    drv.reset(10);
     printf("Reset complete\n");
     
-    // Test configuration
-    int W = 8, H = 8, IC = 16, OC = 16;
-    int stride = 0;  // stride=1
-    int act_bits = 2, wgt_bits = 2;
-    int OH = (H - 3) / (stride + 1) + 1;
-    int OW = (W - 3) / (stride + 1) + 1;
+    // Test configuration: mapped from a tensor file, or the default layer
+    // with random streams
+    golden::TensorFile file;
+    golden::LayerConfig layer;
     
-    printf("Test config: W=%d H=%d IC=%d OC=%d stride=%d act_bits=%d wgt_bits=%d\n",
-           W, H, IC, OC, stride + 1, act_bits, wgt_bits);
-    printf("Output size: OH=%d OW=%d\n", OH, OW);
-    
-    // Send configuration
-    top->cfg_valid = 1;
-    top->cfg_W = W;
-    top->cfg_H = H;
-    top->cfg_IC = IC;
-    top->cfg_OC = OC;
-    top->cfg_stride = stride;
-    top->cfg_act_bits = act_bits;
-    top->cfg_wgt_bits = wgt_bits;
-    top->cfg_mode_raw_out = 1;
-    
-    while (!top->cfg_ready) {
-        top->clk = !top->clk;
-        top->eval();
-        tfp->dump(main_time);
-        main_time++;
+    if (!opt.stimulus.empty()) {
+        if (const char* err = file.open(opt.stimulus.c_str())) {
+            printf("❌ ERROR: %s: %s\n", opt.stimulus.c_str(), err);
+            delete top;
+            return 1;
+        }
+        printf("Stimulus: %s%s\n", opt.stimulus.c_str(),
+               file.has_output() ? " (with expected output)" : "");
+        layer = file.config();
+    } else {
+        layer.W = opt.width; layer.H = 8; layer.IC = 16; layer.OC = 16;
+        layer.stride = 0;  // stride=1
+        layer.act_bits = opt.act_bits;
+        layer.wgt_bits = opt.wgt_bits;
+        srand(time(NULL));
+    }
+    layer.out_bits = opt.out_bits;
+    layer.relu = opt.relu;
+    layer.batch = int(opt.batch);
+    if (opt.pad) {
+        layer.pad = 1;
+        layer.pad_use_code = opt.pad_code >= 0;
+        layer.pad_code = opt.pad_code >= 0 ? uint32_t(opt.pad_code) : 0;
+    }
+    if (const char* err = layer.validate(opt.tile_cols)) {
+        printf("❌ ERROR: layer config: %s\n", err);
+        delete top;
+        return 1;
     }
+    int OH = layer.OH(), OW = layer.OW();
+    int out_elements = (int)layer.out_elements();
     
-    top->cfg_valid = 0;
-    top->start = 1;
-    top->clk = !top->clk;
-    top->eval();
-    tfp->dump(main_time);
-    main_time++;
-    top->start = 0;
+    printf("Test config: W=%d H=%d IC=%d OC=%d stride=%d act_bits=%d wgt_bits=%d\n",
+           layer.W, layer.H, layer.IC, layer.OC, layer.stride_step(), layer.act_bits, layer.wgt_bits);
+    printf("Output size: OH=%d OW=%d\n", OH, OW);
+    if (layer.pad && layer.pad_use_code)
+        printf("Padding: same, border code %u\n", layer.pad_code);
+    else if (layer.pad)
+        printf("Padding: same, zero border\n");
+    if (layer.out_bits != 32)
+        printf("Output: bias/scale%s to %d-bit codes, %zu beats\n", layer.relu ? "/ReLU" : "",
+               layer.out_bits, layer.out_beats());
+    else if (layer.relu)
+        printf("Output: raw sums with ReLU\n");
+    if (opt.layers > 1)
+        printf("Layers: %u back to back\n", opt.layers);
+    if (layer.batch > 1)
+        printf("Batch: %d images per weight load\n", layer.batch);
     
-    printf("Configuration sent, start asserted\n");
+    // Per-layer weights and post-op parameters, per-image activations and
+    // model, and one run of the accelerator (a job) per column tile of each
+    // layer. A job's activation stream holds the tile's columns of every
+    // image of the batch back to back. Each (layer, tile, image) output
+    // block gets its own scoreboard, in output order, and is checked beat by
+    // beat as it is accepted. Expected values come from the tensor file when
+    // it has them; otherwise they are computed per pixel on demand, or with
+    // --golden-threads=N precomputed on N worker threads while the RTL runs.
+    struct LayerData {
+        std::vector<uint8_t> wgt_buf;
+        const uint8_t* wgt = nullptr;
+        golden::PostOps post_ops;
+    };
+    struct ImageRun {
+        std::vector<uint8_t> act_buf;
+        const uint8_t* act = nullptr;
+        std::unique_ptr<golden::ConvGolden> model;
+        std::unique_ptr<golden::ParallelGolden> pool;
+    };
+    struct Job {
+        size_t layer;
+        golden::ColumnTile tile;
+        std::vector<uint8_t> act_buf;
+    };
+    const size_t batch = size_t(layer.batch);
+    const std::vector<golden::ColumnTile> tiles =
+        opt.tile_cols ? golden::column_tiles(layer, opt.tile_cols) : std::vector<golden::ColumnTile>(1);
+    std::vector<LayerData> layers(opt.layers);
+    std::vector<ImageRun> images(opt.layers * batch);
+    std::vector<Job> jobs;
+    std::vector<std::unique_ptr<golden::OutputScoreboard>> scoreboards;
     
-    // Generate and send weights
-    int wgt_elements = OC * IC * 9;
-    int wgt_beats = (wgt_elements * wgt_bits + 127) / 128;
-    printf("Sending %d weights in %d beats...\n", wgt_elements, wgt_beats);
-    
-    srand(time(NULL));
-    int wgt_sent = 0;
-    int beat_count = 0;
-    
-    while (wgt_sent < wgt_elements) {
-        if (top->wgt_in_ready) {
-            top->wgt_in_valid = 1;
-            // Pack 2-bit weights into 128-bit beat (4 x 32-bit words)
-            for (int i = 0; i < 4; i++) {
-                unsigned int word = 0;
-                for (int j = 0; j < 16 && wgt_sent < wgt_elements; j++) {
-                    int w = rand() & 0x3;  // Random 2-bit weight
-                    word |= (w << (j * 2));
-                    wgt_sent++;
-                }
-                top->wgt_in_data[i] = word;
-            }
-            top->wgt_in_last = (wgt_sent >= wgt_elements) ? 1 : 0;
-            beat_count++;
+    for (size_t l = 0; l < layers.size(); l++) {
+        LayerData& d = layers[l];
+        if (!opt.stimulus.empty()) {
+            d.wgt = file.wgt_stream();
+        } else {
+            d.wgt_buf = random_stream(layer.wgt_elements(), layer.wgt_beats(), layer.wgt_bits);
+            d.wgt = d.wgt_buf.data();
         }
-        
-        top->clk = !top->clk;
-        top->eval();
-        tfp->dump(main_time);
-        main_time++;
-        
-        if (top->wgt_in_ready && top->wgt_in_valid) {
-            top->wgt_in_valid = 0;
+        if (layer.out_bits != 32) {
+            for (int oc = 0; oc < layer.OC; oc++) {
+                d.post_ops.bias.push_back(rand() % 201 - 100);
+                d.post_ops.scale.push_back(int16_t(1 + rand() % 255));
+                d.post_ops.shift.push_back(uint8_t(4 + rand() % 8));
+            }
         }
-    }
-    top->wgt_in_valid = 0;
-    printf("Weights sent: %d elements in %d beats\n", wgt_sent, beat_count);
-    
-    // Generate and send activations
-    int act_elements = H * W * IC;
-    int act_beats = (act_elements * act_bits + 127) / 128;
-    printf("Sending %d activations in %d beats...\n", act_elements, act_beats);
-    
-    int act_sent = 0;
-    beat_count = 0;
-    
-    while (act_sent < act_elements) {
-        if (top->act_in_ready) {
-            top->act_in_valid = 1;
-            for (int i = 0; i < 4; i++) {
-                unsigned int word = 0;
-                for (int j = 0; j < 16 && act_sent < act_elements; j++) {
-                    int a = rand() & 0x3;  // Random 2-bit activation
-                    word |= (a << (j * 2));
-                    act_sent++;
-                }
-                top->act_in_data[i] = word;
+        // Every image of a batch replays the file's tensor
+        for (size_t i = 0; i < batch; i++) {
+            ImageRun& r = images[l * batch + i];
+            if (!opt.stimulus.empty()) {
+                r.act = file.act_stream();
+            } else {
+                r.act_buf = random_stream(layer.act_elements(), layer.act_beats(), layer.act_bits);
+                r.act = r.act_buf.data();
             }
-            top->act_in_last = (act_sent >= act_elements) ? 1 : 0;
-            beat_count++;
+            r.model.reset(new golden::ConvGolden(layer, r.act, d.wgt));
+            if (!file.has_output() && opt.golden_threads)
+                r.pool.reset(new golden::ParallelGolden(*r.model, opt.golden_threads));
         }
-        
-        top->clk = !top->clk;
-        top->eval();
-        tfp->dump(main_time);
-        main_time++;
-        
-        if (top->act_in_ready && top->act_in_valid) {
-            top->act_in_valid = 0;
+        for (const golden::ColumnTile& t : tiles) {
+            Job j{l, t, {}};
+            const size_t bytes = t.act_beats(layer) * golden::BUS_BYTES;
+            j.act_buf.resize(bytes * batch);
+            for (size_t i = 0; i < batch; i++) {
+                const ImageRun& r = images[l * batch + i];
+                if (t.W == 0)
+                    memcpy(&j.act_buf[i * bytes], r.act, bytes);
+                else
+                    golden::extract_tile(layer, t, r.act, &j.act_buf[i * bytes]);
+                
+                golden::OutputScoreboard* sb;
+                if (file.has_output())
+                    sb = new golden::OutputScoreboard(layer, file.output());
+                else
+                    sb = new golden::OutputScoreboard(*r.model, r.pool.get());
+                if (t.W != 0)
+                    sb->set_columns(t.ox0(layer), t.OW(layer));
+                if (layer.out_bits != 32)
+                    sb->set_post_ops(&d.post_ops);
+                scoreboards.emplace_back(sb);
+            }
+            jobs.push_back(std::move(j));
         }
     }
-    top->act_in_valid = 0;
-    printf("Activations sent: %d elements in %d beats\n", act_sent, beat_count);
+    if (tiles.size() > 1) {
+        printf("Column tiles (max %d input columns):", opt.tile_cols);
+        for (const golden::ColumnTile& t : tiles)
+            printf(" [%d,%d)->ox %d+%d", t.x0, t.x0 + t.cols(layer), t.ox0(layer), t.OW(layer));
+        printf("\n");
+    }
+    
+    if (!opt.save_stimulus.empty()) {
+        std::vector<int32_t> out = images[0].model->compute();
+        if (const char* err = golden::write_tensor_file(opt.save_stimulus.c_str(), layer,
+                                                        layers[0].wgt, images[0].act, out.data()))
+            printf("[WARN] %s: %s\n", opt.save_stimulus.c_str(), err);
+        else
+            printf("Stimulus saved to %s\n", opt.save_stimulus.c_str());
+    }
+    
+    if (file.has_output())
+        printf("Golden model: expected output from file\n");
+    else
+        printf("Golden model: kernel=%s threads=%u\n", golden::kernel_name(images[0].model->kernel()),
+               images[0].pool ? images[0].pool->threads() : 0);
+    
+    drv.set_sink(scoreboards[0].get());
+    for (size_t n = 1; n < scoreboards.size(); n++)
+        drv.queue_sink(scoreboards[n].get());
+    
+    auto any_failed = [&] {
+        for (const auto& sb : scoreboards)
+            if (sb->failed())
+                return true;
+        return false;
+    };
+    
+    auto run = [&](auto pred, uint64_t max_cycles) {
+        return drv.run_until([&] { return pred() || any_failed(); }, max_cycles);
+    };
+    
+    auto t0 = std::chrono::steady_clock::now();
+    uint64_t cycles_start = drv.cycles();
+    
+    // Post-op parameters go in before the config of their layer.
+    // ST_IDLE leaves for ST_LOAD_WGT on cfg_valid && cfg_ready && start
+    if (layer.out_bits != 32)
+        drv.write_post_ops(layers[0].post_ops, layer.OC);
+    drv.configure(layer, jobs[0].tile);
+    printf("Configuration sent, start asserted\n");
+    
+    // While the layer runs only a config with start may be handshaked (it
+    // goes to the queue slot); one without start must be held off, not
+    // accepted and dropped
+    const bool cfg_ok = !drv.offer_config_without_start(layer, 8);
+    if (!cfg_ok)
+        printf("[FAIL] Config without start accepted while a layer runs\n");
+    
+    const uint64_t max_cycles = 100000 * uint64_t(scoreboards.size());
+    
+    // Send weights
+    printf("Sending %zu weights in %zu beats...\n", layer.wgt_elements(), layer.wgt_beats());
+    drv.send_weights(layers[0].wgt, layer.wgt_beats());
+    run([&] { return drv.weights_done(); }, max_cycles);
+    printf("Weights sent: %zu beats\n", drv.weights_sent());
+    
+    // Send activations: all images of the batch in one stream
+    printf("Sending %zu activations in %zu beats...\n", jobs[0].tile.act_elements(layer) * batch,
+           jobs[0].tile.act_beats(layer) * batch);
+    drv.send_activations(jobs[0].act_buf.data(), jobs[0].tile.act_beats(layer) * batch);
+    
+    // Queue each following layer / tile while the previous one runs: its
+    // config waits in the queue slot and its weights stream into the idle
+    // weight buffer alongside the previous job's activations
+    for (size_t n = 1; n < jobs.size() && !any_failed(); n++) {
+        const Job& j = jobs[n];
+        const LayerData& d = layers[j.layer];
+        if (layer.out_bits != 32)
+            drv.write_post_ops(d.post_ops, layer.OC);
+        drv.configure(layer, j.tile);
+        drv.send_weights(d.wgt, layer.wgt_beats());
+        run([&] { return drv.weights_done() && drv.activations_done(); }, max_cycles);
+        drv.send_activations(j.act_buf.data(), j.tile.act_beats(layer) * batch);
+        if (tiles.size() > 1)
+            printf("Layer %zu tile %zu queued, weights sent\n", j.layer, n % tiles.size());
+        else
+            printf("Layer %zu queued, weights sent\n", j.layer);
+    }
+    
+    run([&] { return drv.activations_done(); }, max_cycles);
+    printf("Activations sent: %zu beats\n", drv.activations_sent());
     
     // Wait for computation and output
     printf("Waiting for computation and output...\n");
+    run([&] {
+        return scoreboards.back()->complete() || drv.out_last_count() >= scoreboards.size();
+    }, max_cycles);
+    if (drv.out_last_count() >= scoreboards.size())
+        printf("Output last beat received\n");
     
-    int out_received = 0;
-    int out_elements = OH * OW * OC;
-    int max_cycles = 100000;
-    int cycles = 0;
-    
-    while (cycles < max_cycles && out_received < out_elements) {
-        top->clk = !top->clk;
-        top->eval();
-        tfp->dump(main_time);
-        main_time++;
-        cycles++;
-        
-        if (top->out_valid && top->out_ready) {
-            // Each beat has 4 x 32-bit outputs
-            out_received += 4;
-            if (top->out_last) {
-                printf("Output last beat received\n");
-                break;
-            }
-        }
-        
-        if (top->done) {
-            printf("Done signal received after %d cycles\n", cycles);
-            break;
+    // Let the FSM reach ST_DONE so the performance counters are final
+    if (!any_failed())
+        run([&] { return drv.layers_done() >= jobs.size(); }, 1000);
+    
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    uint64_t cycles = drv.cycles() - cycles_start;
+    
+    size_t checked = 0;
+    for (const auto& sb : scoreboards)
+        checked += sb->checked();
+    printf("Output checked: %zu of %zu elements\n", checked, size_t(out_elements) * images.size());
+    printf("Total simulation cycles: %llu (%.3f s, %.0f cycles/s)\n",
+           (unsigned long long)cycles, sec, sec > 0 ? cycles / sec : 0.0);
+    
+    bool out_ok = true;
+    for (size_t n = 0; n < scoreboards.size(); n++) {
+        const golden::OutputScoreboard& sb = *scoreboards[n];
+        const size_t l = n / (tiles.size() * batch);
+        const size_t t = n / batch % tiles.size();
+        char name[64];
+        int len = snprintf(name, sizeof(name), "%zu", l);
+        if (tiles.size() > 1)
+            len += snprintf(name + len, sizeof(name) - len, " tile %zu", t);
+        if (batch > 1)
+            snprintf(name + len, sizeof(name) - len, " image %zu", n % batch);
+        out_ok &= sb.complete() && !sb.failed();
+        if (sb.failed()) {
+            const golden::OutputScoreboard::Mismatch& m = sb.mismatch();
+            if (m.oy < 0)
+                printf("[FAIL] Layer %s: output beat after the last element (0x%08x)\n", name, (uint32_t)m.got);
+            else
+                printf("[FAIL] Layer %s: first mismatch at (oy=%d, ox=%d, oc=%d): DUT=%d Golden=%d\n",
+                       name, m.oy, m.ox, m.oc, m.got, m.expected);
+        } else if (!sb.complete()) {
+            printf("[FAIL] Layer %s: only %zu of %zu elements received\n", name, sb.checked(),
+                   sb.expected_total());
         }
     }
+    if (out_ok)
+        printf("[PASS] All %d elements match golden model%s\n", out_elements,
+               opt.layers > 1 ? " in every layer" : batch > 1 ? " in every image" : "");
+    
+    if (jobs.size() > 1) {
+        printf("ST_LOAD_WGT cycles per %s:", tiles.size() > 1 ? "tile" : "layer");
+        for (uint32_t c : drv.load_wgt_cycles())
+            printf(" %u", c);
+        printf("\n");
+    }
     
-    printf("Output received: %d elements\n", out_received);
-    printf("Total simulation cycles: %d\n", cycles);
+    print_perf(top, layer, jobs.back().tile.OW(layer));
     
     // Check error code
-    if (top->error_code != 0) {
+    int top_error = top->error_code;
+    if (top_error != 0) {
         printf("❌ ERROR: error_code = %d\n", top->error_code);
     } else {
         printf("✅ No error detected\n");
@@ -235,9 +482,9 @@ int main(int argc, char** argv) {
     printf(" Simulation Complete\n");
     printf("========================================\n");
     
-    tfp->close();
-    delete tfp;
+    tracer.close();
+    top->final();
     delete top;
     
-    return 0;
+    return (!out_ok || !cfg_ok || top_error) ? 1 : 0;
 }
@@ -0,0 +1,362 @@
+//============================================================================
+// Testbench: tb_weight_buffer.sv
+// Description: weight_buffer read pipeline + conv_core_lowbit throughput test
+//
+// Loads a 2b x 2b layer (IC=64, OC=16) into weight_buffer, then issues one
+// (oc_grp, ic_grp) request per cycle with conv_core_lowbit consuming each
+// block against a fixed window. Checks:
+//   1. every wgt2 block matches the loaded weights, in request order
+//   2. request -> wgt_valid latency is READ_LAT cycles without back-pressure
+//   3. core_in_valid && core_in_ready holds on N_REQ consecutive cycles
+//   4. conv_core partials match a decode2 reference
+// Phase 2 repeats 1/4 with random request gaps and core out_ready
+// back-pressure to check the pipeline neither drops nor duplicates blocks.
+//============================================================================
+
+`timescale 1ns/1ps
+
+module tb_weight_buffer;
+
+    //========================================================================
+    // Parameters
+    //========================================================================
+    localparam int CLK_PERIOD = 10;
+    localparam int BUS_W      = 128;
+    localparam int IC2_LANES  = 16;
+    localparam int OC2_LANES  = 16;
+    localparam int ACC_W      = 32;
+    localparam int KH         = 3;
+    localparam int KW         = 3;
+
+    localparam int IC         = 64;
+    localparam int OC         = 16;
+    localparam int NUM_IC_GRP = IC / IC2_LANES;
+    localparam int N_ELEM     = OC * IC * KH * KW;
+    localparam int EPB        = BUS_W / 2;            // 2-bit elements per beat
+    localparam int N_BEATS    = N_ELEM / EPB;
+    localparam int N_REQ      = 64;
+    localparam int READ_LAT   = 2;
+
+    //========================================================================
+    // Clock and Reset
+    //========================================================================
+    logic clk = 0;
+    logic rst_n;
+
+    always #(CLK_PERIOD/2) clk = ~clk;
+
+    //========================================================================
+    // DUT Signals
+    //========================================================================
+    logic        cfg_valid;
+    logic        cfg_ready;
+
+    logic        wgt_in_valid;
+    logic        wgt_in_ready;
+    logic [BUS_W-1:0] wgt_in_data;
+    logic        wgt_in_last;
+    logic        wgt_load_done;
+
+    logic [7:0]  req_oc_grp;
+    logic [7:0]  req_ic_grp;
+    logic        req_valid;
+    logic        req_ready;
+
+    logic [1:0]  wgt2 [0:OC2_LANES-1][0:KH-1][0:KW-1][0:IC2_LANES-1];
+    logic        wgt_valid;
+    logic        wgt_ready;
+
+    logic [1:0]  act2 [0:KH-1][0:KW-1][0:IC2_LANES-1];
+    logic        core_in_valid;
+    logic        core_in_ready;
+    logic        core_out_valid;
+    logic        core_out_ready;
+    logic signed [ACC_W-1:0] partial [0:OC2_LANES-1];
+    logic signed [ACC_W-1:0] lut_offset;
+
+    //========================================================================
+    // DUT Instantiation
+    //========================================================================
+    weight_buffer #(
+        .MAX_IC(IC),
+        .MAX_OC(OC),
+        .BUS_W(BUS_W),
+        .IC2_LANES(IC2_LANES),
+        .OC2_LANES(OC2_LANES),
+        .KH(KH),
+        .KW(KW)
+    ) u_weight_buffer (
+        .clk(clk),
+        .rst_n(rst_n),
+        .cfg_IC(16'(IC)),
+        .cfg_OC(16'(OC)),
+        .cfg_wgt_bits(5'd2),
+        .cfg_act_bits(5'd2),
+        .cfg_valid(cfg_valid),
+        .cfg_ready(cfg_ready),
+        .wgt_in_valid(wgt_in_valid),
+        .wgt_in_ready(wgt_in_ready),
+        .wgt_in_data(wgt_in_data),
+        .wgt_in_last(wgt_in_last),
+        .wgt_load_done(wgt_load_done),
+        .rd_buf_ready(),
+        .rd_release(1'b0),
+        .req_oc_grp(req_oc_grp),
+        .req_ic_grp(req_ic_grp),
+        .req_valid(req_valid),
+        .req_ready(req_ready),
+        .wgt2(wgt2),
+        .wgt_valid(wgt_valid),
+        .wgt_ready(wgt_ready)
+    );
+
+    conv_core_lowbit #(
+        .IC2_LANES(IC2_LANES),
+        .OC2_LANES(OC2_LANES),
+        .KH(KH),
+        .KW(KW),
+        .ACC_W(ACC_W)
+    ) u_convcore (
+        .clk(clk),
+        .rst_n(rst_n),
+        .in_valid(core_in_valid),
+        .in_ready(core_in_ready),
+        .act2(act2),
+        .act_mask('{default: '{default: 1'b1}}),
+        .wgt2(wgt2),
+        .act_bits(5'd2),
+        .wgt_bits(5'd2),
+        .in_tag(1'b0),
+        .out_valid(core_out_valid),
+        .out_ready(core_out_ready),
+        .partial(partial),
+        .out_tag(),
+        .lut_offset(lut_offset)
+    );
+
+    // The window is always available, so the weight path alone decides
+    // whether the core can fire
+    assign core_in_valid = wgt_valid;
+    assign wgt_ready = core_in_ready;
+
+    //========================================================================
+    // Reference Data
+    //========================================================================
+    // Weight codes, layout ((kh*3+kw)*OC+oc)*IC+ic (same as the stream)
+    logic [1:0] wgt_mem [0:N_ELEM-1];
+
+    function automatic int decode2(input logic [1:0] code);
+        case (code)
+            2'b00: return -3;
+            2'b01: return -1;
+            2'b10: return 1;
+            default: return 3;
+        endcase
+    endfunction
+
+    function automatic logic [1:0] ref_wgt(input int ic_grp, input int oc,
+                                           input int kh, input int kw, input int i);
+        return wgt_mem[((kh * KW + kw) * OC + oc) * IC + ic_grp * IC2_LANES + i];
+    endfunction
+
+    // 2b x 2b partial: dot product of decoded codes, halved by the LUT
+    function automatic int ref_partial(input int ic_grp, input int oc);
+        int sum;
+        sum = 0;
+        for (int kh = 0; kh < KH; kh++)
+            for (int kw = 0; kw < KW; kw++)
+                for (int i = 0; i < IC2_LANES; i++)
+                    sum += decode2(act2[kh][kw][i]) * decode2(ref_wgt(ic_grp, oc, kh, kw, i));
+        return sum / 2;
+    endfunction
+
+    //========================================================================
+    // Request Driver and Scoreboards
+    //========================================================================
+    int  cycle;
+    int  req_total;
+    int  req_sent;
+    bit  req_run;
+    bit  rand_gaps;
+    bit  req_gap;
+
+    int  issue_grp[$];
+    int  issue_cyc[$];
+    int  expect_grp[$];
+
+    int  blocks_seen;
+    int  outs_seen;
+    int  fire_run;
+    int  fire_run_max;
+    int  error_count;
+
+    assign req_oc_grp = 8'd0;
+    assign req_valid  = req_run && (req_sent < req_total) && !req_gap;
+
+    always @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            cycle <= 0;
+            req_sent <= 0;
+            req_ic_grp <= 8'd0;
+            req_gap <= 1'b0;
+            core_out_ready <= 1'b1;
+        end else begin
+            cycle <= cycle + 1;
+            req_gap <= rand_gaps && ($urandom % 4 == 0);
+            core_out_ready <= !rand_gaps || ($urandom % 3 != 0);
+
+            if (req_valid && req_ready) begin
+                issue_grp.push_back(req_ic_grp);
+                issue_cyc.push_back(cycle);
+                req_sent <= req_sent + 1;
+                req_ic_grp <= 8'((req_ic_grp + 1) % NUM_IC_GRP);
+            end
+
+            // Weight block delivered to the core
+            if (core_in_valid && core_in_ready) begin
+                int grp, cyc;
+                bit blk_ok;
+                grp = issue_grp.pop_front();
+                cyc = issue_cyc.pop_front();
+                blk_ok = 1'b1;
+
+                for (int oc = 0; oc < OC2_LANES; oc++)
+                    for (int kh = 0; kh < KH; kh++)
+                        for (int kw = 0; kw < KW; kw++)
+                            for (int i = 0; i < IC2_LANES; i++)
+                                if (wgt2[oc][kh][kw][i] !== ref_wgt(grp, oc, kh, kw, i))
+                                    blk_ok = 1'b0;
+                if (!blk_ok) begin
+                    $display("  FAIL: block %0d (ic_grp=%0d) mismatch", blocks_seen, grp);
+                    error_count++;
+                end
+                if (!rand_gaps && cycle - cyc != READ_LAT) begin
+                    $display("  FAIL: block %0d latency %0d, expected %0d",
+                             blocks_seen, cycle - cyc, READ_LAT);
+                    error_count++;
+                end
+
+                expect_grp.push_back(grp);
+                blocks_seen++;
+                fire_run++;
+                if (fire_run > fire_run_max)
+                    fire_run_max = fire_run;
+            end else begin
+                fire_run = 0;
+            end
+
+            // Core partials, offset by the folded LUT constant
+            if (core_out_valid && core_out_ready) begin
+                int grp;
+                grp = expect_grp.pop_front();
+                for (int oc = 0; oc < OC2_LANES; oc++) begin
+                    if (partial[oc] - lut_offset !== ref_partial(grp, oc)) begin
+                        $display("  FAIL: out %0d lane %0d got=%0d expected=%0d",
+                                 outs_seen, oc, partial[oc] - lut_offset, ref_partial(grp, oc));
+                        error_count++;
+                    end
+                end
+                outs_seen++;
+            end
+        end
+    end
+
+    //========================================================================
+    // Tasks
+    //========================================================================
+    task automatic load_weights();
+        // Config handshake (cfg_ready is high while the loader is idle)
+        @(posedge clk); #1;
+        cfg_valid = 1'b1;
+        @(posedge clk); #1;
+        cfg_valid = 1'b0;
+
+        for (int b = 0; b < N_BEATS; b++) begin
+            wgt_in_valid = 1'b1;
+            wgt_in_last  = (b == N_BEATS - 1);
+            for (int e = 0; e < EPB; e++)
+                wgt_in_data[e*2 +: 2] = wgt_mem[b * EPB + e];
+            do @(posedge clk); while (!wgt_in_ready);
+            #1;
+        end
+        wgt_in_valid = 1'b0;
+        wgt_in_last  = 1'b0;
+
+        wait (wgt_load_done);
+        @(posedge clk); #1;
+    endtask
+
+    task automatic run_requests(input int n, input bit gaps);
+        fire_run = 0;
+        fire_run_max = 0;
+        blocks_seen = 0;
+        outs_seen = 0;
+        rand_gaps = gaps;
+        req_total = req_sent + n;
+        req_run = 1'b1;
+
+        wait (outs_seen == n);
+        @(posedge clk); #1;
+        req_run = 1'b0;
+        rand_gaps = 1'b0;
+
+        if (blocks_seen != n) begin
+            $display("  FAIL: %0d blocks delivered, expected %0d", blocks_seen, n);
+            error_count++;
+        end
+    endtask
+
+    //========================================================================
+    // Main Test Sequence
+    //========================================================================
+    initial begin
+        $display("========================================");
+        $display(" Weight Buffer Pipeline Throughput Test");
+        $display("========================================");
+
+        rst_n = 0;
+        cfg_valid = 0;
+        wgt_in_valid = 0;
+        wgt_in_data = '0;
+        wgt_in_last = 0;
+        req_run = 0;
+        rand_gaps = 0;
+        req_total = 0;
+        error_count = 0;
+
+        for (int n = 0; n < N_ELEM; n++)
+            wgt_mem[n] = 2'($urandom);
+        for (int kh = 0; kh < KH; kh++)
+            for (int kw = 0; kw < KW; kw++)
+                for (int i = 0; i < IC2_LANES; i++)
+                    act2[kh][kw][i] = 2'($urandom);
+
+        repeat(5) @(posedge clk);
+        rst_n = 1;
+
+        $display("Loading %0d weights (%0d beats)...", N_ELEM, N_BEATS);
+        load_weights();
+
+        $display("Phase 1: %0d back-to-back requests", N_REQ);
+        run_requests(N_REQ, 1'b0);
+        $display("  longest core_in_valid && core_in_ready run: %0d cycles", fire_run_max);
+        if (fire_run_max != N_REQ) begin
+            $display("  FAIL: expected %0d consecutive core fires", N_REQ);
+            error_count++;
+        end
+
+        $display("Phase 2: %0d requests with random gaps and back-pressure", N_REQ);
+        run_requests(N_REQ, 1'b1);
+
+        $display("========================================");
+        if (error_count == 0) begin
+            $display("✅ ALL WEIGHT BUFFER TESTS PASSED");
+        end else begin
+            $display("❌ FAILED: %0d errors", error_count);
+        end
+        $display("========================================");
+
+        $finish;
+    end
+
+endmodule